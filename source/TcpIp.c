@@ -26,6 +26,10 @@
  * A implementation of the AUTOSAR TcpIp component on top of berkley sockets
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "TcpIp.h"
 #include "TcpIp_Cfg.h"
 #include "SoAd_Cbk.h"
@@ -33,16 +37,21 @@
 
 #include <unistd.h>
 #include <string.h>
-#include <fcntl.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/poll.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <errno.h>
+#include <limits.h>
 
 #define TCPIP_MODULEID   170u
 #define TCPIP_INSTANCEID 0u
 
+/**
+ * @brief Default and upper limit of the socket buffer size selected at init.
+ */
 #ifndef TCPIP_CFG_MAX_PACKETSIZE
 #define TCPIP_CFG_MAX_PACKETSIZE 1024
 #endif
@@ -55,248 +64,2724 @@
 #define TCPIP_CFG_ENABLE_DEVELOPMENT_ERROR STD_OFF
 #endif
 
-#if(TCPIP_CFG_ENABLE_DEVELOPMENT_ERROR == STD_ON)
-#include "Det.h"
-#define TCPIP_DET_ERROR(api, error) Det_ReportError(TCPIP_MODULEID, TCPIP_INSTANCEID, api, error)
-#define TCPIP_DET_CHECK_RET(check, api, error)       \
-    do {                                             \
-        if (!(check)) {                              \
-            (void)Det_ReportError(TCPIP_MODULEID     \
-                                , TCPIP_INSTANCEID   \
-                                , api                \
-                                , error);            \
-            return E_NOT_OK;                         \
-        }                                            \
-    } while(0)
+/**
+ * @brief Use a persistent epoll interest set instead of polling the full socket table each tick.
+ */
+#ifndef TCPIP_CFG_ENABLE_EPOLL
+#define TCPIP_CFG_ENABLE_EPOLL STD_OFF
+#endif
 
-#else
-#define TCPIP_DET_ERROR(api, error)
-#define TCPIP_DET_CHECK_RET(check, api, error)
+/**
+ * @brief Register sockets edge triggered, ready sockets are drained until EAGAIN.
+ */
+#ifndef TCPIP_CFG_ENABLE_EPOLL_EDGE
+#define TCPIP_CFG_ENABLE_EPOLL_EDGE STD_OFF
 #endif
 
-typedef int TcpIp_OsSocketType;
+/**
+ * @brief Maximum number of ready sockets dispatched per call to TcpIp_MainFunction.
+ */
+#ifndef TCPIP_CFG_EPOLL_EVENTS
+#define TCPIP_CFG_EPOLL_EVENTS 64u
+#endif
 
-#define INVALID_SOCKET (TcpIp_OsSocketType)-1
-#define closesocket(x) close(x)
+#if(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+#include <sys/epoll.h>
+#endif
 
-const TcpIp_ConfigType* TcpIp_Config;
+#if(TCPIP_CFG_ENABLE_EPOLL_EDGE == STD_ON) && (TCPIP_CFG_ENABLE_EPOLL != STD_ON)
+#error TCPIP_CFG_ENABLE_EPOLL_EDGE requires TCPIP_CFG_ENABLE_EPOLL
+#endif
 
+/**
+ * @brief Perform socket I/O through an io_uring submission/completion ring.
+ *
+ * Receive and accept requests are kept posted on every active socket and
+ * transmits are queued, TcpIp_MainFunction submits all queued requests and
+ * turns the available completions into upper layer callbacks with a single
+ * system call. All TcpIp API's must then be called from the thread running
+ * TcpIp_MainFunction.
+ */
+#ifndef TCPIP_CFG_ENABLE_URING
+#define TCPIP_CFG_ENABLE_URING STD_OFF
+#endif
 
-typedef enum {
-    TCPIP_SOCKET_STATE_UNUSED,
-    TCPIP_SOCKET_STATE_ALLOCATED,
-    TCPIP_SOCKET_STATE_BOUND,
-    TCPIP_SOCKET_STATE_LISTEN,
-    TCPIP_SOCKET_STATE_CONNECTING,
-    TCPIP_SOCKET_STATE_CONNECTED,
-    TCPIP_SOCKET_STATE_SHUTDOWN,
-    TCPIP_SOCKET_STATE_FINISHED,
-} TcpIp_SocketStateType;
+/**
+ * @brief Number of submission queue entries of the ring.
+ */
+#ifndef TCPIP_CFG_URING_ENTRIES
+#define TCPIP_CFG_URING_ENTRIES 256u
+#endif
 
-typedef struct {
-    uint8                 tx_buf[TCPIP_CFG_MAX_PACKETSIZE];
-    TcpIp_ProtocolType    protocol;
-    TcpIp_DomainType      domain;
-    TcpIp_SocketStateType state;
-    TcpIp_OsSocketType    fd;
-} TcpIp_SocketType;
+/**
+ * @brief Number of TCPIP_CFG_MAX_PACKETSIZE buffers holding queued transmits.
+ */
+#ifndef TCPIP_CFG_URING_TX_BUFFERS
+#define TCPIP_CFG_URING_TX_BUFFERS 64u
+#endif
 
-typedef struct {
-    TcpIp_StateType       state;
-} TcpIp_EthState;
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
 
-TcpIp_SocketType      TcpIp_Sockets[TCPIP_CFG_MAX_SOCKETS];
-struct pollfd         TcpIp_PollFds[TCPIP_CFG_MAX_SOCKETS];
-TcpIp_EthState        TcpIp_Ctrl[TCPIP_CFG_MAX_CONTROLLER];
+#if(TCPIP_CFG_ENABLE_URING == STD_ON) && (TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+#error TCPIP_CFG_ENABLE_URING and TCPIP_CFG_ENABLE_EPOLL are mutually exclusive
+#endif
 
-static void TcpIp_SocketState_Enter(TcpIp_SocketIdType index, TcpIp_SocketStateType state);
+/**
+ * @brief Provide TcpIp_MainFunctionWait and TcpIp_Wakeup.
+ */
+#ifndef TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT
+#define TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT STD_OFF
+#endif
 
-static void TcpIp_InitSocket(TcpIp_SocketIdType id)
-{
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    memset(s, 0, sizeof(*s));
-    s->state = TCPIP_SOCKET_STATE_UNUSED;
-    s->fd = INVALID_SOCKET;
-}
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON)
+#include <limits.h>
+#define TCPIP_POLLFDS_EXTRA 1u
+#define TCPIP_WAKEUP_INDEX  TcpIp_SocketCount
+#else
+#define TCPIP_POLLFDS_EXTRA 0u
+#endif
+#define TCPIP_POLLFDS_COUNT (TcpIp_SocketCount + TCPIP_POLLFDS_EXTRA)
 
+/**
+ * @brief Provide TcpIp_GetReadinessFd and TcpIp_MainFunctionReady for use
+ *        with an external event loop.
+ */
+#ifndef TCPIP_CFG_ENABLE_READINESS_FD
+#define TCPIP_CFG_ENABLE_READINESS_FD STD_OFF
+#endif
 
-static sint8 TcpIp_GetBsdTypeFromProtocol(TcpIp_ProtocolType  protocol)
-{
-    sint8 res;
-    switch(protocol) {
-        case TCPIP_IPPROTO_TCP:
-            res = SOCK_STREAM;
-            break;
-        case TCPIP_IPPROTO_UDP:
-            res = SOCK_DGRAM;
-            break;
-        default:
-            res = 0;
-    }
-    return res;
-}
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON) && (TCPIP_CFG_ENABLE_EPOLL == STD_OFF) && (TCPIP_CFG_ENABLE_URING == STD_OFF)
+#error TCPIP_CFG_ENABLE_READINESS_FD requires TCPIP_CFG_ENABLE_EPOLL or TCPIP_CFG_ENABLE_URING
+#endif
 
-static sint8 TcpIp_GetBsdDomainFromDomain(TcpIp_DomainType domain)
-{
-    sint8 res;
+/* work handed over by other threads is signalled to a blocking wait and the readiness fd alike */
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON) || (TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+#define TCPIP_WAKEUP_FD STD_ON
+#include <sys/eventfd.h>
+#else
+#define TCPIP_WAKEUP_FD STD_OFF
+#endif
 
-    switch(domain) {
-        case TCPIP_AF_INET:
-            res = AF_INET;
-            break;
-        case TCPIP_AF_INET6:
-            res = AF_INET6;
-            break;
-        default:
-            res = 0;
-    }
-    return res;
-}
+/**
+ * @brief Run the state handlers of ready sockets on a pool of threads.
+ *
+ * A socket is only ever handled by one thread at a time, upper layer
+ * callbacks must not operate on other sockets than the one they are called for.
+ */
+#ifndef TCPIP_CFG_ENABLE_WORKERS
+#define TCPIP_CFG_ENABLE_WORKERS STD_OFF
+#endif
 
-static Std_ReturnType TcpIp_GetBsdSockaddrFromSocketAddr(struct sockaddr_storage* trg, socklen_t* len, const TcpIp_SockAddrType* src)
-{
-    Std_ReturnType res;
-    memset(trg, 0, sizeof(*trg));
-    if (src->domain == TCPIP_AF_INET) {
-        TcpIp_SockAddrInetType* inet = (TcpIp_SockAddrInetType*)src;
-        struct sockaddr_in*     in   = (struct sockaddr_in*)trg;
-        in->sin_family      = AF_INET;
-        in->sin_port        = inet->port;
-        in->sin_addr.s_addr = inet->addr[0];
-        *len = sizeof(*in);
-        res = E_OK;
-    } else if (src->domain == TCPIP_AF_INET6) {
-        TcpIp_SockAddrInet6Type* inet = (TcpIp_SockAddrInet6Type*)src;
-        struct sockaddr_in6*     in6  = (struct sockaddr_in6*)trg;
-        in6->sin6_family = AF_INET6;
-        in6->sin6_port   = inet->port;
-        memcpy(in6->sin6_addr.s6_addr, &inet->addr, sizeof(in6->sin6_addr.s6_addr));
-        *len = sizeof(*in6);
-        res = E_OK;
-    } else {
-        res = E_NOT_OK;
-    }
-    return res;
-}
+/**
+ * @brief Number of threads handling ready sockets, including the main function caller.
+ */
+#ifndef TCPIP_CFG_WORKER_THREADS
+#define TCPIP_CFG_WORKER_THREADS 4u
+#endif
 
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_WORKERS is not supported with TCPIP_CFG_ENABLE_URING
+#endif
 
-static Std_ReturnType TcpIp_GetSockaddrFromBsdSocketAddr(TcpIp_SockAddrStorageType* trg, const struct sockaddr* src)
-{
-    Std_ReturnType res;
-    memset(trg, 0, sizeof(*trg));
-    if (src->sa_family == AF_INET) {
-        struct sockaddr_in*     in   = (struct sockaddr_in*)src;
-        trg->inet.domain  = TCPIP_AF_INET;
-        trg->inet.port    = in->sin_port;
-        trg->inet.addr[0] = in->sin_addr.s_addr;
-        res = E_OK;
-    } else if (src->sa_family == AF_INET6) {
-        struct sockaddr_in6*     in6  = (struct sockaddr_in6*)trg;
-        trg->inet6.domain  = TCPIP_AF_INET6;
-        trg->inet6.port    = in6->sin6_port;
-        memcpy(trg->inet6.addr, in6->sin6_addr.s6_addr, sizeof(trg->inet6.addr));
-        res = E_OK;
-    } else {
-        res = E_NOT_OK;
-    }
-    return res;
-}
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+#include <pthread.h>
+pthread_mutex_t TcpIp_SocketLock = PTHREAD_MUTEX_INITIALIZER;
+#define TCPIP_SOCKET_LOCK()   (void)pthread_mutex_lock(&TcpIp_SocketLock)
+#define TCPIP_SOCKET_UNLOCK() (void)pthread_mutex_unlock(&TcpIp_SocketLock)
+/* ready socket queues of all workers, TcpIp_SocketCount entries each */
+TcpIp_SocketIdType* TcpIp_WorkerItems;
+#else
+#define TCPIP_SOCKET_LOCK()
+#define TCPIP_SOCKET_UNLOCK()
+#endif
 
-static Std_ReturnType TcpIp_SetBlockingState(TcpIp_OsSocketType fd, boolean blocking)
-{
-    Std_ReturnType     res;
-    int flags = fcntl(fd, F_GETFL, 0);
-    if (flags < 0) {
-        res = E_NOT_OK;
-    } else {
-        if (blocking) {
-            flags &= ~O_NONBLOCK;
-        } else {
-            flags |= O_NONBLOCK;
-        }
-        flags = fcntl(fd, F_SETFL, flags);
-        if (flags < 0) {
-            res = E_NOT_OK;
-        } else {
-            res = E_OK;
-        }
-    }
-    return res;
-}
 /**
- * @brief This service initializes the TCP/IP Stack.
+ * @brief Back each listening TCP socket by several SO_REUSEPORT kernel sockets.
  *
- * TcpIp_Init may not block the start-up process for an indefinite amount of time.
- * @note The call of this service is mandatory before using the TcpIp instance for further processing.
- * @param[in] config Pointer to the configuration data of the TcpIp module
+ * The kernel spreads incoming connections over the shards, each with its own
+ * backlog. A shard and the connections accepted from it are run by the same
+ * worker. Every shard beyond the first takes a socket slot of its own.
  */
-void TcpIp_Init(const TcpIp_ConfigType* config)
-{
-    TcpIp_SocketIdType id;
-    uint8              ctrl;
-    TcpIp_Config = config;
+#ifndef TCPIP_CFG_ENABLE_LISTEN_SHARDS
+#define TCPIP_CFG_ENABLE_LISTEN_SHARDS STD_OFF
+#endif
 
-    for (id = 0u; id < TCPIP_CFG_MAX_SOCKETS; ++id) {
-        TcpIp_InitSocket(id);
-    }
+/**
+ * @brief Number of kernel sockets behind one listening socket.
+ */
+#ifndef TCPIP_CFG_LISTEN_SHARDS
+#define TCPIP_CFG_LISTEN_SHARDS TCPIP_CFG_WORKER_THREADS
+#endif
 
-    for (ctrl = 0u; ctrl < TCPIP_CFG_MAX_CONTROLLER; ++ctrl) {
-        TcpIp_Ctrl[ctrl].state = TCPIP_STATE_OFFLINE;
-    }
-}
+/**
+ * @brief Pin worker N to CPU N and steer connections received on CPU N to shard N (SO_INCOMING_CPU).
+ *
+ * The main function caller runs as worker 0 and is never pinned.
+ */
+#ifndef TCPIP_CFG_ENABLE_SHARD_AFFINITY
+#define TCPIP_CFG_ENABLE_SHARD_AFFINITY STD_OFF
+#endif
+
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_LISTEN_SHARDS is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON) && (TCPIP_CFG_LISTEN_SHARDS < 1u)
+#error TCPIP_CFG_LISTEN_SHARDS must be at least 1
+#endif
+
+#if(TCPIP_CFG_ENABLE_SHARD_AFFINITY == STD_ON) && ((TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_OFF) || (TCPIP_CFG_ENABLE_WORKERS == STD_OFF))
+#error TCPIP_CFG_ENABLE_SHARD_AFFINITY requires TCPIP_CFG_ENABLE_LISTEN_SHARDS and TCPIP_CFG_ENABLE_WORKERS
+#endif
+
+#if(TCPIP_CFG_ENABLE_SHARD_AFFINITY == STD_ON)
+#include <sched.h>
+#endif
 
 /**
- * @brief By this API service the TCP/IP stack is requested to change the TcpIp state of the
- *        communication network identified by EthIf controller index.
- * @param[in] id    EthIf controller index to identify the communication network
- *                  where the TcpIp state is requested.
- * @param{in] state Requested TcpIp state
- * @return E_OK:     Service accepted
- *         E_NOT_OK: Service denied
+ * @brief Connections taken from the backlog of a listening socket per readiness event.
  *
- * @req SWS_TCPIP_00071-TODO
- * @req SWS_TCPIP_00072
- * @req SWS_TCPIP_00074-TODO
- * @req SWS_TCPIP_00089
+ * Slots for them are claimed under one lock. With TCPIP_CFG_ENABLE_EPOLL_EDGE
+ * the backlog is always drained, in batches of this size.
  */
-Std_ReturnType TcpIp_RequestComMode(
-        uint8           id,
-        TcpIp_StateType state
-    )
-{
-    Std_ReturnType res;
-    if (id < TCPIP_CFG_MAX_CONTROLLER) {
-        switch (state) {
-            case TCPIP_STATE_OFFLINE: {
-                for (id = 0u; id < TCPIP_CFG_MAX_SOCKETS; ++id) {
-                    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
-                }
-                TcpIp_Ctrl[id].state = state;
-                res = E_OK;
-                break;
-            }
+#ifndef TCPIP_CFG_ACCEPT_BUDGET
+#define TCPIP_CFG_ACCEPT_BUDGET 16u
+#endif
 
-            case TCPIP_STATE_SHUTDOWN:
-            case TCPIP_STATE_STARTUP: {
-                TCPIP_DET_ERROR(TCPIP_API_REQUESTCOMMODE, TCPIP_E_INV_ARG);
-                res = E_NOT_OK;
-                break;
-            }
-            default: {
-                TcpIp_Ctrl[id].state = state;
-                res = E_OK;
-                break;
-            }
-        }
-    } else {
-        res = E_NOT_OK;
-    }
-    return res;
-}
+#if(TCPIP_CFG_ACCEPT_BUDGET < 1u)
+#error TCPIP_CFG_ACCEPT_BUDGET must be at least 1
+#endif
 
 /**
- * @brief By this API service the TCP/IP stack is requested to close the socket and release all related resources.
- * @param[in] Abort TRUE:  connection will immediately be terminated by sending a
+ * @brief Count accepted connections and backlog overflows, read by TcpIp_GetAcceptStats.
+ */
+#ifndef TCPIP_CFG_ENABLE_ACCEPT_STATS
+#define TCPIP_CFG_ENABLE_ACCEPT_STATS STD_OFF
+#endif
+
+/**
+ * @brief Provide TcpIp_UdpTransmitQueued and TcpIp_TcpTransmitQueued, callable from
+ *        any thread, which are sent on the next main function.
+ */
+#ifndef TCPIP_CFG_ENABLE_TX_QUEUE
+#define TCPIP_CFG_ENABLE_TX_QUEUE STD_OFF
+#endif
+
+/**
+ * @brief Number of entries in the transmit queue, one packet each, power of two.
+ */
+#ifndef TCPIP_CFG_TX_QUEUE_ENTRIES
+#define TCPIP_CFG_TX_QUEUE_ENTRIES 64u
+#endif
+
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+#if(TCPIP_CFG_TX_QUEUE_ENTRIES & (TCPIP_CFG_TX_QUEUE_ENTRIES - 1u)) != 0u
+#error TCPIP_CFG_TX_QUEUE_ENTRIES must be a power of two
+#endif
+#include <time.h>
+#endif
+
+/**
+ * @brief Expire sockets stuck in connect, shutdown or idle using a timer wheel.
+ */
+#ifndef TCPIP_CFG_ENABLE_TIMERS
+#define TCPIP_CFG_ENABLE_TIMERS STD_OFF
+#endif
+
+/**
+ * @brief Resolution of the timer wheel in [ms].
+ */
+#ifndef TCPIP_CFG_TIMER_TICK
+#define TCPIP_CFG_TIMER_TICK 10u
+#endif
+
+/**
+ * @brief Time in [ms] a TCP connect may take, 0 disables the timeout.
+ */
+#ifndef TCPIP_CFG_CONNECT_TIMEOUT
+#define TCPIP_CFG_CONNECT_TIMEOUT 30000u
+#endif
+
+/**
+ * @brief Time in [ms] a TCP socket may linger in shutdown or after FIN, 0 disables the timeout.
+ */
+#ifndef TCPIP_CFG_SHUTDOWN_TIMEOUT
+#define TCPIP_CFG_SHUTDOWN_TIMEOUT 10000u
+#endif
+
+/**
+ * @brief Time in [ms] a connected TCP socket may go without receiving data, 0 disables the timeout.
+ */
+#ifndef TCPIP_CFG_IDLE_TIMEOUT
+#define TCPIP_CFG_IDLE_TIMEOUT 0u
+#endif
+
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+#include <time.h>
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+#include <sys/timerfd.h>
+#endif
+#endif
+
+/**
+ * @brief Read UDP sockets with recvmmsg, up to TCPIP_CFG_RX_BATCH datagrams per call.
+ */
+#ifndef TCPIP_CFG_ENABLE_RECVMMSG
+#define TCPIP_CFG_ENABLE_RECVMMSG STD_OFF
+#endif
+
+/**
+ * @brief Number of datagrams read by one recvmmsg call.
+ */
+#ifndef TCPIP_CFG_RX_BATCH
+#define TCPIP_CFG_RX_BATCH 16u
+#endif
+
+/**
+ * @brief Upper layer provides SoAd_RxIndicationBatch, otherwise every datagram
+ *        of a batch is indicated through SoAd_RxIndication.
+ */
+#ifndef TCPIP_CFG_ENABLE_RX_BATCH_INDICATION
+#define TCPIP_CFG_ENABLE_RX_BATCH_INDICATION STD_OFF
+#endif
+
+/**
+ * @brief Enable UDP_GRO on UDP sockets, so a run of datagrams from one peer is read at once.
+ *
+ * The coalesced read is split at the segment size reported by the kernel and
+ * each datagram indicated on its own, or up to TCPIP_CFG_RX_BATCH at a time
+ * through SoAd_RxIndicationBatch.
+ */
+#ifndef TCPIP_CFG_ENABLE_UDP_GRO
+#define TCPIP_CFG_ENABLE_UDP_GRO STD_OFF
+#endif
+
+/**
+ * @brief Size of the buffer a coalesced UDP_GRO read lands in.
+ */
+#ifndef TCPIP_CFG_UDP_GRO_SIZE
+#define TCPIP_CFG_UDP_GRO_SIZE 65535u
+#endif
+
+#if(TCPIP_CFG_ENABLE_RECVMMSG == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_RECVMMSG is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_UDP_GRO == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_UDP_GRO is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_UDP_GRO == STD_ON) && (TCPIP_CFG_ENABLE_RECVMMSG == STD_ON)
+#error TCPIP_CFG_ENABLE_UDP_GRO is not supported with TCPIP_CFG_ENABLE_RECVMMSG
+#endif
+
+#if(TCPIP_CFG_ENABLE_RX_BATCH_INDICATION == STD_ON) && (TCPIP_CFG_ENABLE_RECVMMSG == STD_OFF) && (TCPIP_CFG_ENABLE_UDP_GRO == STD_OFF)
+#error TCPIP_CFG_ENABLE_RX_BATCH_INDICATION requires TCPIP_CFG_ENABLE_RECVMMSG or TCPIP_CFG_ENABLE_UDP_GRO
+#endif
+
+/**
+ * @brief Provide TcpIp_UdpTransmitSegmented, letting the kernel split large payloads with UDP_SEGMENT.
+ *
+ * Sockets on which the kernel refuses segmentation offload fall back to
+ * sending each segment on its own.
+ */
+#ifndef TCPIP_CFG_ENABLE_UDP_GSO
+#define TCPIP_CFG_ENABLE_UDP_GSO STD_OFF
+#endif
+
+#if(TCPIP_CFG_ENABLE_UDP_GSO == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_UDP_GSO is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_UDP_GRO == STD_ON) || (TCPIP_CFG_ENABLE_UDP_GSO == STD_ON)
+#include <netinet/udp.h>
+#endif
+
+#if(TCPIP_CFG_ENABLE_UDP_GSO == STD_ON)
+/** @brief Most segments the kernel accepts in one send */
+#define TCPIP_UDP_GSO_SEGMENTS 64u
+/** @brief Largest payload of one send, bounded by the length field of IPv4 */
+#define TCPIP_UDP_GSO_SIZE     65507u
+#endif
+
+/**
+ * @brief Provide TcpIp_UdpTransmitBatch and TcpIp_UdpTransmitFanout, sending with sendmmsg.
+ */
+#ifndef TCPIP_CFG_ENABLE_SENDMMSG
+#define TCPIP_CFG_ENABLE_SENDMMSG STD_OFF
+#endif
+
+/**
+ * @brief Number of datagrams handed to one sendmmsg call.
+ */
+#ifndef TCPIP_CFG_TX_BATCH
+#define TCPIP_CFG_TX_BATCH 32u
+#endif
+
+#if(TCPIP_CFG_ENABLE_SENDMMSG == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_SENDMMSG is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+/**
+ * @brief Receive into pooled buffers lent to upper layer through SoAd_RxIndicationLoan.
+ *
+ * Upper layer returns E_OK to keep the buffer until it calls TcpIp_RxRelease,
+ * or E_NOT_OK once done with the data. When all buffers are lent out, data is
+ * received on the stack and indicated through SoAd_RxIndication instead.
+ */
+#ifndef TCPIP_CFG_ENABLE_RX_LOAN
+#define TCPIP_CFG_ENABLE_RX_LOAN STD_OFF
+#endif
+
+/**
+ * @brief Number of receive buffers to lend, used when not set in TcpIp_ConfigType.
+ */
+#ifndef TCPIP_CFG_RX_LOAN_BUFFERS
+#define TCPIP_CFG_RX_LOAN_BUFFERS 16u
+#endif
+
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_RX_LOAN is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON) && (TCPIP_CFG_ENABLE_RECVMMSG == STD_ON)
+#error TCPIP_CFG_ENABLE_RX_LOAN is not supported with TCPIP_CFG_ENABLE_RECVMMSG
+#endif
+
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON) && (TCPIP_CFG_ENABLE_UDP_GRO == STD_ON)
+#error TCPIP_CFG_ENABLE_RX_LOAN is not supported with TCPIP_CFG_ENABLE_UDP_GRO
+#endif
+
+/**
+ * @brief Limit TCP reception to the credit upper layer returns through TcpIp_TcpReceived.
+ *
+ * A socket without credit is no longer read, its kernel buffer fills up
+ * and the TCP window holds back the peer until credit is returned.
+ */
+#ifndef TCPIP_CFG_ENABLE_RX_CREDIT
+#define TCPIP_CFG_ENABLE_RX_CREDIT STD_OFF
+#endif
+
+/**
+ * @brief Bytes upper layer accepts on a new TCP socket before confirming any with TcpIp_TcpReceived.
+ */
+#ifndef TCPIP_CFG_RX_CREDIT
+#define TCPIP_CFG_RX_CREDIT 65535u
+#endif
+
+/**
+ * @brief Bytes read ahead per TCP socket and indicated as credit allows, 0 to read no more than the credit.
+ */
+#ifndef TCPIP_CFG_RX_RING_SIZE
+#define TCPIP_CFG_RX_RING_SIZE 0u
+#endif
+
+#if(TCPIP_CFG_RX_RING_SIZE > 0u) && (TCPIP_CFG_ENABLE_RX_CREDIT == STD_OFF)
+#error TCPIP_CFG_RX_RING_SIZE requires TCPIP_CFG_ENABLE_RX_CREDIT
+#endif
+
+#if(TCPIP_CFG_RX_RING_SIZE > 0u) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_RX_RING_SIZE is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+/**
+ * @brief Send large TCP transmits with MSG_ZEROCOPY and confirm them through SoAd_TxConfirmation.
+ *
+ * A TcpIp_TcpTransmit with data of at least TCPIP_CFG_ZEROCOPY_MIN_SIZE bytes
+ * returns while the kernel still reads from the buffer. Upper layer must leave
+ * the buffer alone until SoAd_TxConfirmation has confirmed all of its bytes.
+ */
+#ifndef TCPIP_CFG_ENABLE_ZEROCOPY
+#define TCPIP_CFG_ENABLE_ZEROCOPY STD_OFF
+#endif
+
+/**
+ * @brief Smallest transmit sent without copy, below this copying is cheaper than page pinning.
+ */
+#ifndef TCPIP_CFG_ZEROCOPY_MIN_SIZE
+#define TCPIP_CFG_ZEROCOPY_MIN_SIZE 16384u
+#endif
+
+/**
+ * @brief Zerocopy sends in flight per socket before falling back to copy, must be a power of two.
+ */
+#ifndef TCPIP_CFG_ZEROCOPY_PENDING
+#define TCPIP_CFG_ZEROCOPY_PENDING 64u
+#endif
+
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_ZEROCOPY is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+/**
+ * @brief Never block in TcpIp_TcpTransmit, data the kernel does not take right away
+ *        waits in a per-socket buffer that is sent once the socket signals POLLOUT.
+ *
+ * A transmit that does not fit the buffer is rejected as a whole, so upper
+ * layer can retry it later without having any of it sent twice.
+ */
+#ifndef TCPIP_CFG_ENABLE_TCP_TX_BUFFER
+#define TCPIP_CFG_ENABLE_TCP_TX_BUFFER STD_OFF
+#endif
+
+/**
+ * @brief Bytes buffered per TCP socket, must be a power of two.
+ */
+#ifndef TCPIP_CFG_TCP_TX_BUFFER_SIZE
+#define TCPIP_CFG_TCP_TX_BUFFER_SIZE 16384u
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_TCP_TX_BUFFER is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON) && (TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+#error TCPIP_CFG_ENABLE_TCP_TX_BUFFER is not supported with TCPIP_CFG_ENABLE_ZEROCOPY
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON) && ((TCPIP_CFG_TCP_TX_BUFFER_SIZE & (TCPIP_CFG_TCP_TX_BUFFER_SIZE - 1u)) != 0u)
+#error TCPIP_CFG_TCP_TX_BUFFER_SIZE must be a power of two
+#endif
+
+/**
+ * @brief Send TCP data from lists of segments with sendmsg, without staging it in a transmit buffer.
+ *
+ * Provides TcpIp_TcpTransmitVector, and TcpIp_TcpTransmit without data asks
+ * upper layer for segments through SoAd_GetTxSegments instead of having it
+ * copy through SoAd_CopyTxData.
+ */
+#ifndef TCPIP_CFG_ENABLE_TCP_TX_VECTOR
+#define TCPIP_CFG_ENABLE_TCP_TX_VECTOR STD_OFF
+#endif
+
+/**
+ * @brief Number of segments written by one sendmsg call.
+ */
+#ifndef TCPIP_CFG_TX_SEGMENTS
+#define TCPIP_CFG_TX_SEGMENTS 16u
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_VECTOR == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_TCP_TX_VECTOR is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_VECTOR == STD_ON) && (TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+#error TCPIP_CFG_ENABLE_TCP_TX_VECTOR is not supported with TCPIP_CFG_ENABLE_TCP_TX_BUFFER
+#endif
+
+/**
+ * @brief Coalesce TCP transmits, only a forced transmit pushes the stream out.
+ *
+ * Transmits that are not forced cork the socket (TCP_CORK) so the kernel merges
+ * them with what follows. A forced transmit uncorks it, and so does the end of
+ * the next main function pass, which bounds how long data is held back. Data
+ * pulled through SoAd_CopyTxData is staged in chunks that grow while the kernel
+ * takes them whole, and shrink to what it took when it does not.
+ */
+#ifndef TCPIP_CFG_ENABLE_TCP_COALESCE
+#define TCPIP_CFG_ENABLE_TCP_COALESCE STD_OFF
+#endif
+
+/**
+ * @brief Largest chunk staged per TCP socket when coalescing.
+ */
+#ifndef TCPIP_CFG_TCP_COALESCE_SIZE
+#define TCPIP_CFG_TCP_COALESCE_SIZE 32768u
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_ON)
+#error TCPIP_CFG_ENABLE_TCP_COALESCE is not supported with TCPIP_CFG_ENABLE_URING
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON) && (TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+#error TCPIP_CFG_ENABLE_TCP_COALESCE is not supported with TCPIP_CFG_ENABLE_TCP_TX_BUFFER
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON) && (TCPIP_CFG_TCP_COALESCE_SIZE > 65535u)
+#error TCPIP_CFG_TCP_COALESCE_SIZE must fit the length of SoAd_CopyTxData
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+#define TCPIP_TCP_TX_DONE(index, force, res) TcpIp_TcpTx_Done(index, force, res)
+#else
+#define TCPIP_TCP_TX_DONE(index, force, res) (res)
+#endif
+
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON) && ((TCPIP_CFG_ZEROCOPY_PENDING & (TCPIP_CFG_ZEROCOPY_PENDING - 1u)) != 0u)
+#error TCPIP_CFG_ZEROCOPY_PENDING must be a power of two
+#endif
+
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+#include <linux/errqueue.h>
+#include <netinet/ip.h>
+#endif
+
+/**
+ * @brief Size of the smallest transmit pool buffer, each further class doubles up to the packet size.
+ */
+#ifndef TCPIP_CFG_TX_POOL_MIN_SIZE
+#define TCPIP_CFG_TX_POOL_MIN_SIZE 128u
+#endif
+
+/**
+ * @brief Number of buffers in each transmit pool class, used when not set in TcpIp_ConfigType.
+ */
+#ifndef TCPIP_CFG_TX_POOL_BUFFERS
+#define TCPIP_CFG_TX_POOL_BUFFERS 4u
+#endif
+
+/**
+ * @brief Tag socket ids with a generation so ids of released sockets are rejected.
+ */
+#ifndef TCPIP_CFG_ENABLE_SOCKET_GENERATION
+#define TCPIP_CFG_ENABLE_SOCKET_GENERATION STD_OFF
+#endif
+
+/**
+ * @brief Low bits of a socket id holding the slot index, the rest holds the generation.
+ */
+#ifndef TCPIP_CFG_SOCKET_INDEX_BITS
+#define TCPIP_CFG_SOCKET_INDEX_BITS 10u
+#endif
+
+#if(TCPIP_CFG_ENABLE_SOCKET_GENERATION == STD_ON)
+#if(TCPIP_CFG_SOCKET_INDEX_BITS >= 16u) || (TCPIP_CFG_MAX_SOCKETS > (1u << TCPIP_CFG_SOCKET_INDEX_BITS))
+#error TCPIP_CFG_SOCKET_INDEX_BITS must cover TCPIP_CFG_MAX_SOCKETS and leave room for a generation
+#endif
+#define TCPIP_SOCKET_INDEX_MASK  ((1u << TCPIP_CFG_SOCKET_INDEX_BITS) - 1u)
+#define TCPIP_SOCKET_INDEX(id)   ((TcpIp_SocketIdType)((id) & TCPIP_SOCKET_INDEX_MASK))
+#define TCPIP_SOCKET_ID(index)   (TcpIp_Sockets[index].id)
+#else
+#define TCPIP_SOCKET_INDEX(id)   (id)
+#define TCPIP_SOCKET_ID(index)   (index)
+#endif
+
+/**
+ * @brief Count the system calls issued on behalf of each API, read by TcpIp_GetSyscallStats.
+ */
+#ifndef TCPIP_CFG_ENABLE_SYSCALL_STATS
+#define TCPIP_CFG_ENABLE_SYSCALL_STATS STD_OFF
+#endif
+
+#if(TCPIP_CFG_ENABLE_SYSCALL_STATS == STD_ON)
+TcpIp_SyscallStatsType TcpIp_SyscallStats;
+#define TCPIP_SYSCALL_COUNT(api) (void)__atomic_fetch_add(&TcpIp_SyscallStats.api, 1u, __ATOMIC_RELAXED)
+#else
+#define TCPIP_SYSCALL_COUNT(api)
+#endif
+
+#if(TCPIP_CFG_ENABLE_ACCEPT_STATS == STD_ON)
+TcpIp_AcceptStatsType TcpIp_AcceptStats;
+#define TCPIP_ACCEPT_COUNT(field) (void)__atomic_fetch_add(&TcpIp_AcceptStats.field, 1u, __ATOMIC_RELAXED)
+#else
+#define TCPIP_ACCEPT_COUNT(field)
+#endif
+
+#if(TCPIP_CFG_ENABLE_DEVELOPMENT_ERROR == STD_ON)
+#include "Det.h"
+#define TCPIP_DET_ERROR(api, error) Det_ReportError(TCPIP_MODULEID, TCPIP_INSTANCEID, api, error)
+#define TCPIP_DET_CHECK_RET(check, api, error)       \
+    do {                                             \
+        if (!(check)) {                              \
+            (void)Det_ReportError(TCPIP_MODULEID     \
+                                , TCPIP_INSTANCEID   \
+                                , api                \
+                                , error);            \
+            return E_NOT_OK;                         \
+        }                                            \
+    } while(0)
+
+#else
+#define TCPIP_DET_ERROR(api, error)
+#define TCPIP_DET_CHECK_RET(check, api, error)
+#endif
+
+typedef int TcpIp_OsSocketType;
+
+#define INVALID_SOCKET (TcpIp_OsSocketType)-1
+#define closesocket(x) close(x)
+
+const TcpIp_ConfigType* TcpIp_Config;
+
+
+typedef enum {
+    TCPIP_SOCKET_STATE_UNUSED,
+    TCPIP_SOCKET_STATE_ALLOCATED,
+    TCPIP_SOCKET_STATE_BOUND,
+    TCPIP_SOCKET_STATE_LISTEN,
+    TCPIP_SOCKET_STATE_CONNECTING,
+    TCPIP_SOCKET_STATE_CONNECTED,
+    TCPIP_SOCKET_STATE_SHUTDOWN,
+    TCPIP_SOCKET_STATE_FINISHED,
+} TcpIp_SocketStateType;
+
+typedef struct {
+    TcpIp_ProtocolType    protocol;
+    TcpIp_DomainType      domain;
+    TcpIp_SocketStateType state;
+    TcpIp_OsSocketType    fd;
+#if(TCPIP_CFG_ENABLE_SOCKET_GENERATION == STD_ON)
+    TcpIp_SocketIdType    id;
+    uint16                generation;
+#endif
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+    uint32                rx_credit;
+    boolean               rx_paused;
+#endif
+#if(TCPIP_CFG_ENABLE_UDP_GSO == STD_ON)
+    boolean               udp_gso_off;
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    uint32                tx_chunk;
+    boolean               tx_corked;
+    boolean               tx_cork_listed; /**< on the TcpIp_TxCorked list, only cleared by the main function */
+    TcpIp_SocketIdType    tx_cork_next;   /**< next socket on the TcpIp_TxCorked list */
+#endif
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+    TcpIp_SocketIdType    shard_owner; /**< listening socket this shard belongs to, invalid if not a shard */
+    TcpIp_SocketIdType    shard_next;  /**< next shard of the same listening socket */
+    uint16                shard_home;  /**< worker running the socket, TCPIP_SHARD_NONE if any */
+#endif
+} TcpIp_SocketType;
+
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+#define TCPIP_SHARD_NONE 0xffffu
+#endif
+
+typedef struct {
+    TcpIp_StateType       state;
+} TcpIp_EthState;
+
+/* tables placed in the arena by TcpIp_Init */
+TcpIp_SocketIdType    TcpIp_SocketCount;
+uint16                TcpIp_PacketSize;
+uint8                 TcpIp_CtrlCount;
+TcpIp_SocketType*     TcpIp_Sockets;
+TcpIp_SocketIdType*   TcpIp_FreeSockets;
+uint32                TcpIp_FreeHead;
+uint32                TcpIp_FreeCount;
+struct pollfd*        TcpIp_PollFds;
+TcpIp_EthState*       TcpIp_Ctrl;
+/* remote address of connected TCP sockets, known once connected or accepted */
+TcpIp_SockAddrStorageType* TcpIp_Peers;
+
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+/* set when credit was returned to a socket that had run out */
+boolean               TcpIp_RxResume;
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+/* sockets corked since the main function last uncorked, linked through tx_cork_next */
+TcpIp_SocketIdType    TcpIp_TxCorked;
+#endif
+
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+/**
+ * @brief Data read ahead of the credit, refilled from the socket once drained
+ */
+typedef struct {
+    uint32                head;
+    uint32                tail;
+} TcpIp_RxRingType;
+
+TcpIp_RxRingType*     TcpIp_RxRings;
+uint8*                TcpIp_RxRingData;
+#endif
+
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+/**
+ * @brief Zerocopy sends of a socket, the kernel numbers them from 0 and completes them by range
+ *
+ * Only the sending thread writes next, completions reaped while its send
+ * has not returned yet are remembered in early.
+ */
+typedef struct {
+    uint32                next;
+    uint32                len[TCPIP_CFG_ZEROCOPY_PENDING];
+    boolean               early;
+    boolean               enabled;
+    boolean               tried;
+} TcpIp_ZerocopyType;
+
+TcpIp_ZerocopyType*   TcpIp_Zerocopy;
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+/**
+ * @brief Data taken by TcpIp_TcpTransmit but not yet by the kernel, head and tail count bytes
+ */
+typedef struct {
+    uint32                head;
+    uint32                tail;
+    boolean               shutdown;
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    pthread_mutex_t       lock;     /**< serializes sends of the socket, never held with TCPIP_SOCKET_LOCK */
+#endif
+} TcpIp_TcpTxType;
+
+TcpIp_TcpTxType*      TcpIp_TcpTx;
+uint8*                TcpIp_TcpTxData;
+
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+#define TCPIP_TCP_TX_LOCK(index)   (void)pthread_mutex_lock(&TcpIp_TcpTx[index].lock)
+#define TCPIP_TCP_TX_UNLOCK(index) (void)pthread_mutex_unlock(&TcpIp_TcpTx[index].lock)
+#else
+#define TCPIP_TCP_TX_LOCK(index)
+#define TCPIP_TCP_TX_UNLOCK(index)
+#endif
+#endif
+
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+/**
+ * @brief Entry of the transmit queue, its payload is kept in TcpIp_TxQueueData
+ *
+ * The sequence number tells producers and the consumer who owns the entry,
+ * it equals the position for a free entry and position + 1 for a filled one.
+ */
+typedef struct {
+    uint32                    seq;
+    TcpIp_SocketIdType        id;
+    TcpIp_ProtocolType        protocol;
+    uint16                    len;
+    uint64                    stamp;
+    TcpIp_SockAddrStorageType remote;
+} TcpIp_TxQueueEntryType;
+
+TcpIp_TxQueueEntryType* TcpIp_TxQueue;
+uint8*                  TcpIp_TxQueueData;
+uint32                  TcpIp_TxQueueTail;
+uint32                  TcpIp_TxQueueHead;
+TcpIp_TxQueueStatsType  TcpIp_TxQueueStats;
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+/** @brief Staging of each TCP socket, TCPIP_CFG_TCP_COALESCE_SIZE bytes each */
+uint8*                TcpIp_TcpCoalesceData;
+#endif
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+/** @brief Upper bound of transmit pool classes, enough for any 16 bit packet size */
+#define TCPIP_TX_POOL_CLASSES 16u
+
+/**
+ * @brief Transmit buffers of one size, borrowed for the duration of a transmit call
+ */
+typedef struct {
+    uint8*                base;
+    uint16*               free;
+    uint16                size;
+    uint16                available;
+    uint16                in_use_max;
+    uint32                exhausted;
+} TcpIp_TxPoolType;
+
+/**
+ * @brief Bytes of one buffer of each class, as TcpIp_TxPool_ClassSize for the compile time packet size
+ *
+ * A class exists as long as the one before it was still smaller than the packet size.
+ */
+#define TCPIP_TX_POOL_CLASS_BYTES(cls)                                                                  \
+    ((((cls) == 0u) || ((TCPIP_CFG_TX_POOL_MIN_SIZE << ((cls) - 1u)) < TCPIP_CFG_MAX_PACKETSIZE))        \
+        ? (((TCPIP_CFG_TX_POOL_MIN_SIZE << (cls)) < TCPIP_CFG_MAX_PACKETSIZE)                           \
+            ? (TCPIP_CFG_TX_POOL_MIN_SIZE << (cls)) : TCPIP_CFG_MAX_PACKETSIZE)                         \
+        : 0u)
+
+#define TCPIP_TX_POOL_BYTES                                                                             \
+    ( TCPIP_TX_POOL_CLASS_BYTES(0u)  + TCPIP_TX_POOL_CLASS_BYTES(1u)  + TCPIP_TX_POOL_CLASS_BYTES(2u)     \
+    + TCPIP_TX_POOL_CLASS_BYTES(3u)  + TCPIP_TX_POOL_CLASS_BYTES(4u)  + TCPIP_TX_POOL_CLASS_BYTES(5u)     \
+    + TCPIP_TX_POOL_CLASS_BYTES(6u)  + TCPIP_TX_POOL_CLASS_BYTES(7u)  + TCPIP_TX_POOL_CLASS_BYTES(8u)     \
+    + TCPIP_TX_POOL_CLASS_BYTES(9u)  + TCPIP_TX_POOL_CLASS_BYTES(10u) + TCPIP_TX_POOL_CLASS_BYTES(11u)    \
+    + TCPIP_TX_POOL_CLASS_BYTES(12u) + TCPIP_TX_POOL_CLASS_BYTES(13u) + TCPIP_TX_POOL_CLASS_BYTES(14u)    \
+    + TCPIP_TX_POOL_CLASS_BYTES(15u))
+
+TcpIp_TxPoolType      TcpIp_TxPool[TCPIP_TX_POOL_CLASSES];
+uint8                 TcpIp_TxPoolClasses;
+uint16                TcpIp_TxPoolBuffers;
+uint8*                TcpIp_TxPoolData;
+uint16*               TcpIp_TxPoolFree;
+#endif
+
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+#define TCPIP_RX_POOL_NONE 0xffffu
+
+/* free list is a stack linked through TcpIp_RxPoolNext, head tagged against ABA */
+uint8*                TcpIp_RxPoolData;
+uint16*               TcpIp_RxPoolNext;
+/* set while a buffer is lent to upper layer, cleared by the one release that returns it */
+boolean*              TcpIp_RxPoolLent;
+uint16                TcpIp_RxPoolBuffers;
+uint32                TcpIp_RxPoolHead;
+uint32                TcpIp_RxPoolInUse;
+uint32                TcpIp_RxPoolInUseMax;
+uint32                TcpIp_RxPoolLoaned;
+uint32                TcpIp_RxPoolFallback;
+#endif
+
+#if(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+int                   TcpIp_EpollFd = -1;
+struct epoll_event    TcpIp_EpollEvents[TCPIP_CFG_EPOLL_EVENTS];
+int                   TcpIp_EpollCount;
+int                   TcpIp_EpollNext;
+#endif
+
+#if(TCPIP_WAKEUP_FD == STD_ON)
+int                   TcpIp_WakeupFd = -1;
+
+/** @brief epoll user data of the wakeup eventfd, never a valid socket index */
+#define TCPIP_EPOLL_WAKEUP 0xffffffffffffffffu
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+static void TcpIp_Wakeup_Clear(void)
+{
+    uint64 v;
+    TCPIP_SYSCALL_COUNT(main_function);
+    (void)read(TcpIp_WakeupFd, &v, sizeof(v));
+}
+#endif
+
+/* signal the wakeup eventfd, whether or not a wait is in progress */
+#define TCPIP_WAKEUP_SIGNAL() do {                                    \
+        uint64 wakeup_ = 1u;                                          \
+        TCPIP_SYSCALL_COUNT(wakeup);                                  \
+        (void)write(TcpIp_WakeupFd, &wakeup_, sizeof(wakeup_));       \
+    } while (0)
+#endif
+
+/**
+ * @brief Have the main function pick up work handed over by another thread.
+ *
+ * An external event loop only learns about it through the readiness fd, so with
+ * that in use the eventfd is signalled even when no wait is in progress.
+ */
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+#define TCPIP_NOTIFY() TCPIP_WAKEUP_SIGNAL()
+#elif(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON)
+#define TCPIP_NOTIFY() TcpIp_Wakeup()
+#else
+#define TCPIP_NOTIFY()
+#endif
+
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON)
+boolean               TcpIp_Waiting;
+
+/* flag the span where the main function thread is blocked */
+#define TCPIP_WAIT_BEGIN(timeout) __atomic_store_n(&TcpIp_Waiting, (boolean)((timeout) != 0), __ATOMIC_SEQ_CST)
+#define TCPIP_WAIT_END()          __atomic_store_n(&TcpIp_Waiting, FALSE, __ATOMIC_SEQ_CST)
+#else
+#define TCPIP_WAIT_BEGIN(timeout)
+#define TCPIP_WAIT_END()
+#endif
+
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+#define TCPIP_TIMER_BITS   6u
+#define TCPIP_TIMER_SLOTS  (1u << TCPIP_TIMER_BITS)
+#define TCPIP_TIMER_MASK   (TCPIP_TIMER_SLOTS - 1u)
+#define TCPIP_TIMER_LEVELS 4u
+#define TCPIP_TIMER_NONE   0xffffu
+
+/** @brief Longest delay in ticks the wheel can represent */
+#define TCPIP_TIMER_MAX    ((1u << (TCPIP_TIMER_BITS * TCPIP_TIMER_LEVELS)) - 1u)
+
+/**
+ * @brief Timer of a socket, linked into one slot of the wheel while armed
+ */
+typedef struct {
+    TcpIp_SocketIdType next;
+    TcpIp_SocketIdType prev;
+    uint16             slot;
+    uint32             expires;
+    uint32             timeout;
+    uint32             activity;
+} TcpIp_TimerType;
+
+TcpIp_TimerType*   TcpIp_Timers;
+TcpIp_SocketIdType TcpIp_TimerWheel[TCPIP_TIMER_LEVELS * TCPIP_TIMER_SLOTS];
+uint32             TcpIp_TimerNow;
+uint32             TcpIp_TimerArmed;
+
+#if(TCPIP_WAKEUP_FD == STD_ON)
+/** @brief Tick the main function next looks at the wheel, earlier timers have to wake it */
+uint32             TcpIp_TimerPlanned;
+boolean            TcpIp_TimerPlannedValid;
+#endif
+
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+int                TcpIp_TimerFd = -1;
+uint32             TcpIp_TimerProgrammed;
+boolean            TcpIp_TimerProgrammedValid;
+uint64             TcpIp_TimerValue;
+
+/** @brief epoll user data of the timerfd, never a valid socket index */
+#define TCPIP_EPOLL_TIMER  0xfffffffffffffffeu
+#endif
+#endif
+
+static void TcpIp_SocketState_Enter(TcpIp_SocketIdType index, TcpIp_SocketStateType state);
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+static Std_ReturnType TcpIp_AllocSocket(TcpIp_DomainType domain, TcpIp_ProtocolType protocol, TcpIp_SocketIdType* index);
+#endif
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+static void TcpIp_Uring_InitSocket(TcpIp_SocketIdType index);
+#endif
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+static void TcpIp_Worker_Start(void);
+#endif
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+static void TcpIp_TxQueue_Init(void);
+static void TcpIp_TxQueue_Drain(void);
+#endif
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+static void TcpIp_Timer_Init(void);
+static void TcpIp_Timer_Update(TcpIp_SocketIdType index, TcpIp_SocketStateType state);
+static void TcpIp_Timer_Advance(void);
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON) || (TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+static int  TcpIp_Timer_NextTimeout(void);
+#endif
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+static void TcpIp_Timer_Program(void);
+#endif
+#define TCPIP_TIMER_ACTIVITY(index) (TcpIp_Timers[index].activity = TcpIp_TimerNow)
+#else
+#define TCPIP_TIMER_ACTIVITY(index)
+#endif
+
+static void TcpIp_InitSocket(TcpIp_SocketIdType id)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[id];
+    struct pollfd*    p = &TcpIp_PollFds[id];
+    memset(s, 0, sizeof(*s));
+    s->state = TCPIP_SOCKET_STATE_UNUSED;
+    s->fd    = INVALID_SOCKET;
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+    s->shard_owner = TCPIP_SOCKETID_INVALID;
+    s->shard_next  = TCPIP_SOCKETID_INVALID;
+    s->shard_home  = TCPIP_SHARD_NONE;
+#endif
+
+    memset(p, 0, sizeof(*p));
+    p->fd = INVALID_SOCKET;
+
+    memset(&TcpIp_Peers[id], 0, sizeof(TcpIp_Peers[id]));
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    TcpIp_Uring_InitSocket(id);
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON) && (TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    (void)pthread_mutex_init(&TcpIp_TcpTx[id].lock, NULL);
+#endif
+}
+
+/**
+ * @brief Append a released slot to the free list, caller holds TCPIP_SOCKET_LOCK
+ *
+ * Slots are reused in release order so an id is not handed out again right away.
+ */
+static void TcpIp_FreeSocket_Push(TcpIp_SocketIdType index)
+{
+    TcpIp_FreeSockets[(TcpIp_FreeHead + TcpIp_FreeCount) % TcpIp_SocketCount] = index;
+    TcpIp_FreeCount++;
+#if(TCPIP_CFG_ENABLE_SOCKET_GENERATION == STD_ON)
+    TcpIp_Sockets[index].id = TCPIP_SOCKETID_INVALID;
+#endif
+}
+
+/**
+ * @brief Return a slot claimed by TcpIp_AllocSockets that upper layer never got to know
+ */
+static void TcpIp_FreeSocket_Release(TcpIp_SocketIdType index)
+{
+    TCPIP_SOCKET_LOCK();
+    TcpIp_Sockets[index].state = TCPIP_SOCKET_STATE_UNUSED;
+    TcpIp_FreeSocket_Push(index);
+    TCPIP_SOCKET_UNLOCK();
+}
+
+static TcpIp_SocketIdType TcpIp_FreeSocket_Pop(void)
+{
+    TcpIp_SocketIdType index = TcpIp_FreeSockets[TcpIp_FreeHead];
+    TcpIp_FreeHead = (TcpIp_FreeHead + 1u) % TcpIp_SocketCount;
+    TcpIp_FreeCount--;
+    return index;
+}
+
+/**
+ * @brief Translate a socket id given by upper layer into its slot index
+ * @return E_OK:     id refers to a slot (with generations, to the current allocation of it)
+ *         E_NOT_OK: id is out of range or stale
+ */
+static Std_ReturnType TcpIp_SocketIndex(TcpIp_SocketIdType id, TcpIp_SocketIdType* index)
+{
+    TcpIp_SocketIdType i = TCPIP_SOCKET_INDEX(id);
+
+    if (i >= TcpIp_SocketCount) {
+        return E_NOT_OK;
+    }
+#if(TCPIP_CFG_ENABLE_SOCKET_GENERATION == STD_ON)
+    if (__atomic_load_n(&TcpIp_Sockets[i].id, __ATOMIC_RELAXED) != id) {
+        return E_NOT_OK;
+    }
+#endif
+    *index = i;
+    return E_OK;
+}
+
+#if(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+/**
+ * @brief Drop any not yet dispatched event for a socket that left the interest set
+ *
+ * The slot may be reused by a new connection before the current batch is done.
+ */
+static void TcpIp_Epoll_Forget(TcpIp_SocketIdType index)
+{
+    int i;
+    for (i = TcpIp_EpollNext; i < TcpIp_EpollCount; ++i) {
+        if (TcpIp_EpollEvents[i].data.u64 == index) {
+            TcpIp_EpollEvents[i].events = 0u;
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Update the events a socket is waiting on
+ *
+ * With epoll the kernel interest set is kept in sync, TcpIp_PollFds[].fd
+ * then holds the descriptor currently registered for the slot.
+ */
+static void TcpIp_SocketEvents_Update(TcpIp_SocketIdType index, short events)
+{
+    struct pollfd*    p = &TcpIp_PollFds[index];
+#if(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+    TcpIp_SocketType*  s = &TcpIp_Sockets[index];
+    struct epoll_event ev;
+    int                op;
+
+    ev.events   = (uint32)events;
+#if(TCPIP_CFG_ENABLE_EPOLL_EDGE == STD_ON)
+    ev.events  |= EPOLLET;
+#endif
+    ev.data.u64 = index;
+
+    if ((p->fd != INVALID_SOCKET) && ((events == 0) || (p->fd != s->fd))) {
+        TCPIP_SYSCALL_COUNT(events);
+        (void)epoll_ctl(TcpIp_EpollFd, EPOLL_CTL_DEL, p->fd, NULL);
+        TcpIp_Epoll_Forget(index);
+        p->fd = INVALID_SOCKET;
+    }
+
+    if ((events != 0) && (s->fd != INVALID_SOCKET)) {
+        if (p->fd == INVALID_SOCKET) {
+            op = EPOLL_CTL_ADD;
+        } else if (p->events != events) {
+            op = EPOLL_CTL_MOD;
+        } else {
+            op = 0;
+        }
+
+        if (op != 0) {
+            TCPIP_SYSCALL_COUNT(events);
+            if (epoll_ctl(TcpIp_EpollFd, op, s->fd, &ev) == 0) {
+                p->fd = s->fd;
+            }
+        }
+    }
+#elif(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON) && (TCPIP_CFG_ENABLE_URING == STD_OFF)
+    /* a poll in progress works on a copy of the table, have it pick up the change */
+    if (p->events != events) {
+        TcpIp_Wakeup();
+    }
+#endif
+    p->events = events;
+}
+
+/**
+ * @brief Events wanted by a connected TCP socket
+ */
+static short TcpIp_SocketEvents_Stream(TcpIp_SocketIdType index)
+{
+    short events = POLLIN;
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+    if (TcpIp_Sockets[index].rx_paused) {
+        events = 0;
+    }
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+    if (__atomic_load_n(&TcpIp_TcpTx[index].head, __ATOMIC_ACQUIRE) != __atomic_load_n(&TcpIp_TcpTx[index].tail, __ATOMIC_ACQUIRE)) {
+        events |= POLLOUT;
+    }
+#endif
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_OFF) && (TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_OFF)
+    (void)index;
+#endif
+    return events;
+}
+
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+/**
+ * @brief Clamp a read to the credit left, stop reading the socket when there is none
+ *
+ * Reading is resumed by TcpIp_RxCredit_Resume once TcpIp_TcpReceived returns credit.
+ */
+static uint32 TcpIp_RxCredit_Limit(TcpIp_SocketIdType index, uint32 size)
+{
+    TcpIp_SocketType* s      = &TcpIp_Sockets[index];
+    uint32            credit = __atomic_load_n(&s->rx_credit, __ATOMIC_ACQUIRE);
+
+    if (credit == 0u) {
+        s->rx_paused = TRUE;
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+        TcpIp_SocketEvents_Update(index, TcpIp_SocketEvents_Stream(index));
+#endif
+    }
+    return (credit < size) ? credit : size;
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+
+#define TCPIP_URING_OP_RX       1u
+#define TCPIP_URING_OP_TX       2u
+#define TCPIP_URING_OP_CANCEL   3u
+#define TCPIP_URING_OP_WAKEUP   4u
+#define TCPIP_URING_OP_TIMER    5u
+
+#define TCPIP_URING_USERDATA(op, index) (((uint64)(op) << 32) | (uint64)(index))
+
+#define TCPIP_URING_TX_NONE     0xffffu
+#define TCPIP_URING_OPCODE_NONE IORING_OP_NOP
+
+typedef struct {
+    int                     fd;
+    uint32                  sq_entries;
+    uint32                  sq_tail;
+    uint32                  sq_pending;
+    boolean                 processing;
+    int                     ready_fd;
+    uint32*                 sq_head_ptr;
+    uint32*                 sq_tail_ptr;
+    uint32*                 sq_mask_ptr;
+    uint32*                 sq_flags_ptr;
+    uint32*                 sq_array;
+    struct io_uring_sqe*    sqes;
+    uint32*                 cq_head_ptr;
+    uint32*                 cq_tail_ptr;
+    uint32*                 cq_mask_ptr;
+    struct io_uring_cqe*    cqes;
+    void*                   sq_ptr;
+    size_t                  sq_len;
+    void*                   cq_ptr;
+    size_t                  cq_len;
+    size_t                  sqes_len;
+} TcpIp_UringType;
+
+typedef struct {
+    uint8                   buf[TCPIP_CFG_MAX_PACKETSIZE];
+    struct sockaddr_storage addr;
+    struct msghdr           msg;
+    struct iovec            iov;
+    uint16                  len;
+    uint16                  offset;
+    uint16                  next;
+} TcpIp_UringTxType;
+
+typedef struct {
+    uint8*                  rx_buf;
+    struct sockaddr_storage rx_addr;
+    socklen_t               rx_addr_len;
+    struct msghdr           rx_msg;
+    struct iovec            rx_iov;
+    uint8                   rx_opcode;
+    boolean                 rx_pending;
+    boolean                 rx_cancel;
+    boolean                 tx_pending;
+    boolean                 tx_cancel;
+    boolean                 tx_shutdown;
+    uint16                  tx_head;
+    uint16                  tx_tail;
+} TcpIp_UringSocketType;
+
+TcpIp_UringType       TcpIp_Uring = { .fd = -1, .ready_fd = -1 };
+TcpIp_UringSocketType* TcpIp_UringSockets;
+uint8*                 TcpIp_UringRxBuffers;
+TcpIp_UringTxType     TcpIp_UringTx[TCPIP_CFG_URING_TX_BUFFERS];
+uint16                TcpIp_UringTxFree;
+uint16                TcpIp_UringTxFreeCount;
+
+static void TcpIp_Uring_Destroy(void)
+{
+    TcpIp_UringType* r = &TcpIp_Uring;
+    if (r->sqes != NULL) {
+        munmap(r->sqes, r->sqes_len);
+    }
+    if ((r->cq_ptr != NULL) && (r->cq_ptr != r->sq_ptr)) {
+        munmap(r->cq_ptr, r->cq_len);
+    }
+    if (r->sq_ptr != NULL) {
+        munmap(r->sq_ptr, r->sq_len);
+    }
+    if (r->fd != -1) {
+        close(r->fd);
+    }
+    if (r->ready_fd != -1) {
+        close(r->ready_fd);
+    }
+    memset(r, 0, sizeof(*r));
+    r->fd       = -1;
+    r->ready_fd = -1;
+}
+
+static Std_ReturnType TcpIp_Uring_Setup(void)
+{
+    TcpIp_UringType*       r = &TcpIp_Uring;
+    struct io_uring_params params;
+    uint16                 index;
+    uint8*                 sq;
+    uint8*                 cq;
+
+    TcpIp_Uring_Destroy();
+
+    for (index = 0u; index < TCPIP_CFG_URING_TX_BUFFERS; ++index) {
+        TcpIp_UringTx[index].next = index + 1u;
+    }
+    TcpIp_UringTx[TCPIP_CFG_URING_TX_BUFFERS - 1u].next = TCPIP_URING_TX_NONE;
+    TcpIp_UringTxFree      = 0u;
+    TcpIp_UringTxFreeCount = TCPIP_CFG_URING_TX_BUFFERS;
+
+    memset(&params, 0, sizeof(params));
+    r->fd = (int)syscall(__NR_io_uring_setup, TCPIP_CFG_URING_ENTRIES, &params);
+    if (r->fd < 0) {
+        r->fd = -1;
+        return E_NOT_OK;
+    }
+
+    r->sq_len = params.sq_off.array + params.sq_entries * sizeof(uint32);
+    r->cq_len = params.cq_off.cqes  + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_len > r->sq_len) {
+            r->sq_len = r->cq_len;
+        }
+        r->cq_len = r->sq_len;
+    }
+
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED) {
+        r->sq_ptr = NULL;
+        TcpIp_Uring_Destroy();
+        return E_NOT_OK;
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ptr = r->sq_ptr;
+    } else {
+        r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+        if (r->cq_ptr == MAP_FAILED) {
+            r->cq_ptr = NULL;
+            TcpIp_Uring_Destroy();
+            return E_NOT_OK;
+        }
+    }
+
+    r->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        r->sqes = NULL;
+        TcpIp_Uring_Destroy();
+        return E_NOT_OK;
+    }
+
+    sq = (uint8*)r->sq_ptr;
+    cq = (uint8*)r->cq_ptr;
+    r->sq_entries   = params.sq_entries;
+    r->sq_head_ptr  = (uint32*)(sq + params.sq_off.head);
+    r->sq_tail_ptr  = (uint32*)(sq + params.sq_off.tail);
+    r->sq_mask_ptr  = (uint32*)(sq + params.sq_off.ring_mask);
+    r->sq_flags_ptr = (uint32*)(sq + params.sq_off.flags);
+    r->sq_array     = (uint32*)(sq + params.sq_off.array);
+    r->cq_head_ptr  = (uint32*)(cq + params.cq_off.head);
+    r->cq_tail_ptr  = (uint32*)(cq + params.cq_off.tail);
+    r->cq_mask_ptr  = (uint32*)(cq + params.cq_off.ring_mask);
+    r->cqes         = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    r->sq_tail      = *r->sq_tail_ptr;
+    r->sq_pending   = 0u;
+
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    /* kernel signals the eventfd for every completion posted */
+    r->ready_fd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((r->ready_fd == -1)
+    ||  (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_EVENTFD, &r->ready_fd, 1) < 0)) {
+        TcpIp_Uring_Destroy();
+        return E_NOT_OK;
+    }
+#endif
+    return E_OK;
+}
+
+/**
+ * @brief Hand all prepared submission entries to the kernel
+ * @param[in] min_complete Number of completions to wait for
+ * @param[in] flags        IORING_ENTER_* flags
+ * @param[in] timeout      Maximum wait in milliseconds, negative waits forever
+ */
+static int TcpIp_Uring_Enter(uint32 min_complete, uint32 flags, int timeout)
+{
+    TcpIp_UringType*               r = &TcpIp_Uring;
+    struct io_uring_getevents_arg  arg;
+    struct __kernel_timespec       ts;
+    void*                          arg_ptr = NULL;
+    size_t                         arg_len = 0u;
+    int                            res;
+
+    if ((min_complete > 0u) && (timeout >= 0)) {
+        ts.tv_sec      = timeout / 1000;
+        ts.tv_nsec     = (timeout % 1000) * 1000000L;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts         = (uint64)(uintptr_t)&ts;
+        arg_ptr        = &arg;
+        arg_len        = sizeof(arg);
+        flags         |= IORING_ENTER_EXT_ARG;
+    }
+
+    TCPIP_SYSCALL_COUNT(main_function);
+    res = (int)syscall(__NR_io_uring_enter, r->fd, r->sq_pending, min_complete, flags, arg_ptr, arg_len);
+    if (res >= 0) {
+        r->sq_pending -= (uint32)res;
+    } else {
+        res = -errno;
+    }
+    return res;
+}
+
+static struct io_uring_sqe* TcpIp_Uring_GetSqe(void)
+{
+    TcpIp_UringType*     r = &TcpIp_Uring;
+    struct io_uring_sqe* sqe;
+    uint32               head;
+    uint32               index;
+
+    if (r->fd == -1) {
+        return NULL;
+    }
+
+    head = __atomic_load_n(r->sq_head_ptr, __ATOMIC_ACQUIRE);
+    if (r->sq_tail - head >= r->sq_entries) {
+        /* ring is full, make room by submitting what we have */
+        (void)TcpIp_Uring_Enter(0u, 0u, 0);
+        head = __atomic_load_n(r->sq_head_ptr, __ATOMIC_ACQUIRE);
+        if (r->sq_tail - head >= r->sq_entries) {
+            return NULL;
+        }
+    }
+
+    index = r->sq_tail & *r->sq_mask_ptr;
+    sqe   = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[index] = index;
+    return sqe;
+}
+
+/**
+ * @brief Publish the entry last returned by TcpIp_Uring_GetSqe
+ */
+static void TcpIp_Uring_Commit(void)
+{
+    TcpIp_UringType* r = &TcpIp_Uring;
+    r->sq_tail++;
+    r->sq_pending++;
+    __atomic_store_n(r->sq_tail_ptr, r->sq_tail, __ATOMIC_RELEASE);
+
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    /* queued from outside the main function, have the event loop come back to submit it */
+    if ((r->sq_pending == 1u) && !r->processing) {
+        uint64 v = 1u;
+        TCPIP_SYSCALL_COUNT(wakeup);
+        (void)write(r->ready_fd, &v, sizeof(v));
+    }
+#endif
+}
+
+/**
+ * @brief Cancel a request
+ *
+ * A request still waiting for submission is turned into a no-op, it must not
+ * reach the kernel as its file descriptor number may be reused by then.
+ *
+ * @return TRUE:  Request was revoked before submission, no completion will follow
+ *         FALSE: Cancellation requested, the request will still complete
+ */
+static boolean TcpIp_Uring_Cancel(uint64 user_data)
+{
+    TcpIp_UringType*     r = &TcpIp_Uring;
+    struct io_uring_sqe* sqe;
+    uint32               pos;
+
+    for (pos = r->sq_tail - r->sq_pending; pos != r->sq_tail; ++pos) {
+        sqe = &r->sqes[r->sq_array[pos & *r->sq_mask_ptr]];
+        if (sqe->user_data == user_data) {
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode    = IORING_OP_NOP;
+            sqe->fd        = -1;
+            sqe->user_data = TCPIP_URING_USERDATA(TCPIP_URING_OP_CANCEL, 0u);
+            return TRUE;
+        }
+    }
+
+    sqe = TcpIp_Uring_GetSqe();
+    if (sqe != NULL) {
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->fd        = -1;
+        sqe->addr      = user_data;
+        sqe->user_data = TCPIP_URING_USERDATA(TCPIP_URING_OP_CANCEL, 0u);
+        TcpIp_Uring_Commit();
+    }
+    return FALSE;
+}
+
+#if(TCPIP_WAKEUP_FD == STD_ON)
+uint64 TcpIp_UringWakeupValue;
+
+/**
+ * @brief Keep a read posted on the wakeup eventfd, its completion ends a blocking wait
+ */
+static void TcpIp_Uring_ArmWakeup(void)
+{
+    struct io_uring_sqe* sqe = TcpIp_Uring_GetSqe();
+    if (sqe != NULL) {
+        sqe->opcode    = IORING_OP_READ;
+        sqe->fd        = TcpIp_WakeupFd;
+        sqe->addr      = (uint64)(uintptr_t)&TcpIp_UringWakeupValue;
+        sqe->len       = sizeof(TcpIp_UringWakeupValue);
+        sqe->user_data = TCPIP_URING_USERDATA(TCPIP_URING_OP_WAKEUP, 0u);
+        TcpIp_Uring_Commit();
+    }
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON) && (TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+/**
+ * @brief Keep a read posted on the timerfd, its completion signals the readiness eventfd
+ */
+static void TcpIp_Uring_ArmTimer(void)
+{
+    struct io_uring_sqe* sqe = TcpIp_Uring_GetSqe();
+    if (sqe != NULL) {
+        sqe->opcode    = IORING_OP_READ;
+        sqe->fd        = TcpIp_TimerFd;
+        sqe->addr      = (uint64)(uintptr_t)&TcpIp_TimerValue;
+        sqe->len       = sizeof(TcpIp_TimerValue);
+        sqe->user_data = TCPIP_URING_USERDATA(TCPIP_URING_OP_TIMER, 0u);
+        TcpIp_Uring_Commit();
+    }
+}
+#endif
+
+static uint16 TcpIp_Uring_TxAlloc(void)
+{
+    uint16 slot = TcpIp_UringTxFree;
+    if (slot != TCPIP_URING_TX_NONE) {
+        TcpIp_UringTxFree = TcpIp_UringTx[slot].next;
+        TcpIp_UringTxFreeCount--;
+        TcpIp_UringTx[slot].next   = TCPIP_URING_TX_NONE;
+        TcpIp_UringTx[slot].offset = 0u;
+        TcpIp_UringTx[slot].len    = 0u;
+    }
+    return slot;
+}
+
+static void TcpIp_Uring_TxRelease(uint16 slot)
+{
+    TcpIp_UringTx[slot].next = TcpIp_UringTxFree;
+    TcpIp_UringTxFree        = slot;
+    TcpIp_UringTxFreeCount++;
+}
+
+/**
+ * @brief Remove and release the oldest queued transmit of a socket
+ */
+static void TcpIp_Uring_TxPop(TcpIp_SocketIdType index)
+{
+    TcpIp_UringSocketType* u    = &TcpIp_UringSockets[index];
+    uint16                 slot = u->tx_head;
+
+    u->tx_head = TcpIp_UringTx[slot].next;
+    if (u->tx_head == TCPIP_URING_TX_NONE) {
+        u->tx_tail = TCPIP_URING_TX_NONE;
+    }
+    TcpIp_Uring_TxRelease(slot);
+}
+
+/**
+ * @brief Post the oldest queued transmit of a socket unless one is already in flight
+ *
+ * Only one transmit per socket is in flight at any time to keep stream ordering.
+ */
+static void TcpIp_Uring_TxKick(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType*      s = &TcpIp_Sockets[index];
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+    TcpIp_UringTxType*     t;
+    struct io_uring_sqe*   sqe;
+
+    if (u->tx_pending || (u->tx_head == TCPIP_URING_TX_NONE)) {
+        return;
+    }
+
+    sqe = TcpIp_Uring_GetSqe();
+    if (sqe == NULL) {
+        return;
+    }
+
+    t = &TcpIp_UringTx[u->tx_head];
+    sqe->fd        = s->fd;
+    sqe->user_data = TCPIP_URING_USERDATA(TCPIP_URING_OP_TX, index);
+    if (s->protocol == TCPIP_IPPROTO_UDP) {
+        sqe->opcode    = IORING_OP_SENDMSG;
+        sqe->addr      = (uint64)(uintptr_t)&t->msg;
+        sqe->len       = 1u;
+        sqe->msg_flags = MSG_NOSIGNAL;
+    } else {
+        sqe->opcode    = IORING_OP_SEND;
+        sqe->addr      = (uint64)(uintptr_t)&t->buf[t->offset];
+        sqe->len       = t->len - t->offset;
+        sqe->msg_flags = MSG_NOSIGNAL;
+    }
+    TcpIp_Uring_Commit();
+    u->tx_pending = TRUE;
+}
+
+/**
+ * @brief Queue a filled transmit buffer on a socket
+ */
+static void TcpIp_Uring_TxQueue(TcpIp_SocketIdType index, uint16 slot)
+{
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+
+    if (u->tx_tail == TCPIP_URING_TX_NONE) {
+        u->tx_head = slot;
+    } else {
+        TcpIp_UringTx[u->tx_tail].next = slot;
+    }
+    u->tx_tail = slot;
+    TcpIp_Uring_TxKick(index);
+}
+
+/**
+ * @brief Bring the posted requests of a socket in line with its state
+ *
+ * Called whenever the socket changes state and after each completion.
+ * Requests no longer wanted are cancelled, the slot stays busy until
+ * their completions have been reaped.
+ */
+static void TcpIp_Uring_Arm(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType*      s = &TcpIp_Sockets[index];
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+    struct pollfd*         p = &TcpIp_PollFds[index];
+    struct io_uring_sqe*   sqe;
+    uint8                  opcode;
+
+    if (s->fd == INVALID_SOCKET) {
+        opcode = TCPIP_URING_OPCODE_NONE;
+    } else {
+        switch (s->state) {
+            case TCPIP_SOCKET_STATE_LISTEN:
+                opcode = IORING_OP_ACCEPT;
+                break;
+            case TCPIP_SOCKET_STATE_CONNECTED:
+            case TCPIP_SOCKET_STATE_SHUTDOWN:
+                opcode = IORING_OP_RECV;
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+                if (TcpIp_RxCredit_Limit(index, 1u) == 0u) {
+                    opcode = TCPIP_URING_OPCODE_NONE;
+                }
+#endif
+                break;
+            case TCPIP_SOCKET_STATE_BOUND:
+                if (s->protocol == TCPIP_IPPROTO_UDP) {
+                    opcode = IORING_OP_RECVMSG;
+                } else {
+                    opcode = IORING_OP_POLL_ADD;
+                }
+                break;
+            case TCPIP_SOCKET_STATE_CONNECTING:
+                opcode = IORING_OP_POLL_ADD;
+                break;
+            default:
+                opcode = TCPIP_URING_OPCODE_NONE;
+                break;
+        }
+    }
+
+    if (u->rx_pending && (u->rx_opcode != opcode) && !u->rx_cancel) {
+        if (TcpIp_Uring_Cancel(TCPIP_URING_USERDATA(TCPIP_URING_OP_RX, index))) {
+            u->rx_pending = FALSE;
+        } else {
+            u->rx_cancel  = TRUE;
+        }
+    }
+
+    if (!u->rx_pending && (opcode != TCPIP_URING_OPCODE_NONE)) {
+        sqe = TcpIp_Uring_GetSqe();
+        if (sqe != NULL) {
+            sqe->opcode    = opcode;
+            sqe->fd        = s->fd;
+            sqe->user_data = TCPIP_URING_USERDATA(TCPIP_URING_OP_RX, index);
+            switch (opcode) {
+                case IORING_OP_ACCEPT:
+                    u->rx_addr_len  = sizeof(u->rx_addr);
+                    sqe->addr       = (uint64)(uintptr_t)&u->rx_addr;
+                    sqe->addr2      = (uint64)(uintptr_t)&u->rx_addr_len;
+                    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+                    break;
+                case IORING_OP_RECV:
+                    sqe->addr       = (uint64)(uintptr_t)u->rx_buf;
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+                    sqe->len        = TcpIp_RxCredit_Limit(index, TcpIp_PacketSize);
+#else
+                    sqe->len        = TcpIp_PacketSize;
+#endif
+                    break;
+                case IORING_OP_RECVMSG:
+                    memset(&u->rx_msg, 0, sizeof(u->rx_msg));
+                    u->rx_iov.iov_base    = u->rx_buf;
+                    u->rx_iov.iov_len     = TcpIp_PacketSize;
+                    u->rx_msg.msg_name    = &u->rx_addr;
+                    u->rx_msg.msg_namelen = sizeof(u->rx_addr);
+                    u->rx_msg.msg_iov     = &u->rx_iov;
+                    u->rx_msg.msg_iovlen  = 1u;
+                    sqe->addr       = (uint64)(uintptr_t)&u->rx_msg;
+                    sqe->len        = 1u;
+                    break;
+                default:
+                    sqe->poll32_events = (uint32)p->events;
+                    break;
+            }
+            TcpIp_Uring_Commit();
+            u->rx_opcode  = opcode;
+            u->rx_pending = TRUE;
+            u->rx_cancel  = FALSE;
+        }
+    }
+
+    if (s->state == TCPIP_SOCKET_STATE_UNUSED) {
+        if (u->tx_pending && !u->tx_cancel) {
+            if (TcpIp_Uring_Cancel(TCPIP_URING_USERDATA(TCPIP_URING_OP_TX, index))) {
+                u->tx_pending = FALSE;
+            } else {
+                u->tx_cancel  = TRUE;
+            }
+        }
+
+        /* drop everything not yet handed to the kernel, the buffer in flight is released on completion */
+        uint16 keep = u->tx_pending ? u->tx_head : TCPIP_URING_TX_NONE;
+        uint16 slot = u->tx_pending ? TcpIp_UringTx[keep].next : u->tx_head;
+        while (slot != TCPIP_URING_TX_NONE) {
+            uint16 next = TcpIp_UringTx[slot].next;
+            TcpIp_Uring_TxRelease(slot);
+            slot = next;
+        }
+        if (keep != TCPIP_URING_TX_NONE) {
+            TcpIp_UringTx[keep].next = TCPIP_URING_TX_NONE;
+        }
+        u->tx_head     = keep;
+        u->tx_tail     = keep;
+        u->tx_shutdown = FALSE;
+    }
+}
+
+/**
+ * @brief Check that no request still references the buffers of a socket slot
+ */
+static boolean TcpIp_Uring_Idle(TcpIp_SocketIdType index)
+{
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+    return !u->rx_pending && !u->tx_pending;
+}
+
+static void TcpIp_Uring_InitSocket(TcpIp_SocketIdType index)
+{
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+    u->rx_buf      = &TcpIp_UringRxBuffers[(uint32)index * TcpIp_PacketSize];
+    u->rx_pending  = FALSE;
+    u->rx_cancel   = FALSE;
+    u->tx_pending  = FALSE;
+    u->tx_cancel   = FALSE;
+    u->tx_shutdown = FALSE;
+    u->tx_head     = TCPIP_URING_TX_NONE;
+    u->tx_tail     = TCPIP_URING_TX_NONE;
+}
+#endif
+
+
+static sint8 TcpIp_GetBsdTypeFromProtocol(TcpIp_ProtocolType  protocol)
+{
+    sint8 res;
+    switch(protocol) {
+        case TCPIP_IPPROTO_TCP:
+            res = SOCK_STREAM;
+            break;
+        case TCPIP_IPPROTO_UDP:
+            res = SOCK_DGRAM;
+            break;
+        default:
+            res = 0;
+    }
+    return res;
+}
+
+static sint8 TcpIp_GetBsdDomainFromDomain(TcpIp_DomainType domain)
+{
+    sint8 res;
+
+    switch(domain) {
+        case TCPIP_AF_INET:
+            res = AF_INET;
+            break;
+        case TCPIP_AF_INET6:
+            res = AF_INET6;
+            break;
+        default:
+            res = 0;
+    }
+    return res;
+}
+
+static Std_ReturnType TcpIp_GetBsdSockaddrFromSocketAddr(struct sockaddr_storage* trg, socklen_t* len, const TcpIp_SockAddrType* src)
+{
+    Std_ReturnType res;
+    memset(trg, 0, sizeof(*trg));
+    if (src->domain == TCPIP_AF_INET) {
+        TcpIp_SockAddrInetType* inet = (TcpIp_SockAddrInetType*)src;
+        struct sockaddr_in*     in   = (struct sockaddr_in*)trg;
+        in->sin_family      = AF_INET;
+        in->sin_port        = inet->port;
+        in->sin_addr.s_addr = inet->addr[0];
+        *len = sizeof(*in);
+        res = E_OK;
+    } else if (src->domain == TCPIP_AF_INET6) {
+        TcpIp_SockAddrInet6Type* inet = (TcpIp_SockAddrInet6Type*)src;
+        struct sockaddr_in6*     in6  = (struct sockaddr_in6*)trg;
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port   = inet->port;
+        memcpy(in6->sin6_addr.s6_addr, &inet->addr, sizeof(in6->sin6_addr.s6_addr));
+        *len = sizeof(*in6);
+        res = E_OK;
+    } else {
+        res = E_NOT_OK;
+    }
+    return res;
+}
+
+
+static Std_ReturnType TcpIp_GetSockaddrFromBsdSocketAddr(TcpIp_SockAddrStorageType* trg, const struct sockaddr* src)
+{
+    Std_ReturnType res;
+    memset(trg, 0, sizeof(*trg));
+    if (src->sa_family == AF_INET) {
+        struct sockaddr_in*     in   = (struct sockaddr_in*)src;
+        trg->inet.domain  = TCPIP_AF_INET;
+        trg->inet.port    = in->sin_port;
+        trg->inet.addr[0] = in->sin_addr.s_addr;
+        res = E_OK;
+    } else if (src->sa_family == AF_INET6) {
+        struct sockaddr_in6*     in6  = (struct sockaddr_in6*)src;
+        trg->inet6.domain  = TCPIP_AF_INET6;
+        trg->inet6.port    = in6->sin6_port;
+        memcpy(trg->inet6.addr, in6->sin6_addr.s6_addr, sizeof(trg->inet6.addr));
+        res = E_OK;
+    } else {
+        res = E_NOT_OK;
+    }
+    return res;
+}
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+/**
+ * @brief Wait until a socket takes more data after a send reported EAGAIN
+ *
+ * Sockets stay non-blocking from creation, transmits only block here when the
+ * kernel buffer is full instead of switching mode on every call.
+ */
+static Std_ReturnType TcpIp_WaitWritable(TcpIp_OsSocketType fd)
+{
+    struct pollfd p;
+    p.fd      = fd;
+    p.events  = POLLOUT;
+    p.revents = 0;
+    if ((poll(&p, 1u, -1) < 0) && (errno != EINTR)) {
+        return E_NOT_OK;
+    }
+    return E_OK;
+}
+#endif
+/**
+ * @brief Bump allocator placing the tables sized at init, counts only when base is NULL
+ */
+typedef struct {
+    uint8* base;
+    uint32 used;
+} TcpIp_ArenaType;
+
+#define TCPIP_ARENA_ALIGN  16u
+
+/** @brief Upper bound of tables placed by TcpIp_Arena_Layout, each may waste alignment */
+#define TCPIP_ARENA_TABLES 23u
+
+#define TCPIP_ARENA_TABLE(arena, table, count) do {                                   \
+        void* p_ = TcpIp_Arena_Alloc((arena), (uint32)(count) * (uint32)sizeof(*(table))); \
+        if ((arena)->base != NULL) {                                                  \
+            (table) = p_;                                                             \
+        }                                                                             \
+    } while (0)
+
+/**
+ * @brief Tables for the compile time defaults, only used to size the built in arena
+ */
+typedef struct {
+    TcpIp_SocketType      sockets[TCPIP_CFG_MAX_SOCKETS];
+    TcpIp_SocketIdType    free[TCPIP_CFG_MAX_SOCKETS];
+    struct pollfd         pollfds[TCPIP_CFG_MAX_SOCKETS + TCPIP_POLLFDS_EXTRA];
+    TcpIp_EthState        ctrl[TCPIP_CFG_MAX_CONTROLLER];
+    TcpIp_SockAddrStorageType peers[TCPIP_CFG_MAX_SOCKETS];
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TcpIp_TimerType       timers[TCPIP_CFG_MAX_SOCKETS];
+#endif
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    TcpIp_UringSocketType uring[TCPIP_CFG_MAX_SOCKETS];
+    uint8                 uring_buffers[TCPIP_CFG_MAX_SOCKETS * TCPIP_CFG_MAX_PACKETSIZE];
+#else
+    uint8                 tx_pool[TCPIP_CFG_TX_POOL_BUFFERS * TCPIP_TX_POOL_BYTES];
+    uint16                tx_pool_free[TCPIP_CFG_TX_POOL_BUFFERS * TCPIP_TX_POOL_CLASSES];
+#endif
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    TcpIp_SocketIdType    workers[TCPIP_CFG_WORKER_THREADS * TCPIP_CFG_MAX_SOCKETS];
+#endif
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    uint8                 rx_pool[TCPIP_CFG_RX_LOAN_BUFFERS * TCPIP_CFG_MAX_PACKETSIZE];
+    uint16                rx_pool_next[TCPIP_CFG_RX_LOAN_BUFFERS];
+    boolean               rx_pool_lent[TCPIP_CFG_RX_LOAN_BUFFERS];
+#endif
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+    TcpIp_RxRingType      rx_rings[TCPIP_CFG_MAX_SOCKETS];
+    uint8                 rx_ring_data[TCPIP_CFG_MAX_SOCKETS * TCPIP_CFG_RX_RING_SIZE];
+#endif
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+    TcpIp_ZerocopyType    zerocopy[TCPIP_CFG_MAX_SOCKETS];
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+    TcpIp_TcpTxType       tcp_tx[TCPIP_CFG_MAX_SOCKETS];
+    uint8                 tcp_tx_data[TCPIP_CFG_MAX_SOCKETS * TCPIP_CFG_TCP_TX_BUFFER_SIZE];
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    uint8                 tcp_coalesce_data[TCPIP_CFG_MAX_SOCKETS * TCPIP_CFG_TCP_COALESCE_SIZE];
+#endif
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+    TcpIp_TxQueueEntryType tx_queue[TCPIP_CFG_TX_QUEUE_ENTRIES];
+    uint8                 tx_queue_data[TCPIP_CFG_TX_QUEUE_ENTRIES * TCPIP_CFG_MAX_PACKETSIZE];
+#endif
+} TcpIp_StaticArenaType;
+
+uint64 TcpIp_StaticArena[(sizeof(TcpIp_StaticArenaType) + TCPIP_ARENA_TABLES * TCPIP_ARENA_ALIGN) / sizeof(uint64)];
+
+static void* TcpIp_Arena_Alloc(TcpIp_ArenaType* arena, uint32 size)
+{
+    uint32 offset = (arena->used + (TCPIP_ARENA_ALIGN - 1u)) & ~(TCPIP_ARENA_ALIGN - 1u);
+    arena->used = offset + size;
+    if (arena->base == NULL) {
+        return NULL;
+    }
+    return &arena->base[offset];
+}
+
+/**
+ * @brief Table sizes selected by a configuration
+ */
+typedef struct {
+    uint32 sockets;
+    uint32 packetsize;
+    uint32 controllers;
+    uint32 tx_buffers;
+    uint32 tx_classes;
+    uint32 tx_bytes;
+    uint32 rx_buffers;
+} TcpIp_ArenaSizesType;
+
+/**
+ * @brief Place all tables sized by the configuration
+ */
+static void TcpIp_Arena_Layout(TcpIp_ArenaType* arena, const TcpIp_ArenaSizesType* sizes)
+{
+    TCPIP_ARENA_TABLE(arena, TcpIp_Sockets      , sizes->sockets);
+    TCPIP_ARENA_TABLE(arena, TcpIp_FreeSockets  , sizes->sockets);
+    TCPIP_ARENA_TABLE(arena, TcpIp_PollFds      , sizes->sockets + TCPIP_POLLFDS_EXTRA);
+    TCPIP_ARENA_TABLE(arena, TcpIp_Ctrl         , sizes->controllers);
+    TCPIP_ARENA_TABLE(arena, TcpIp_Peers        , sizes->sockets);
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_Timers       , sizes->sockets);
+#endif
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_UringSockets  , sizes->sockets);
+    TCPIP_ARENA_TABLE(arena, TcpIp_UringRxBuffers, sizes->sockets * sizes->packetsize);
+#else
+    TCPIP_ARENA_TABLE(arena, TcpIp_TxPoolData   , sizes->tx_buffers * sizes->tx_bytes);
+    TCPIP_ARENA_TABLE(arena, TcpIp_TxPoolFree   , sizes->tx_buffers * sizes->tx_classes);
+#endif
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_WorkerItems  , TCPIP_CFG_WORKER_THREADS * sizes->sockets);
+#endif
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_RxPoolData   , sizes->rx_buffers * sizes->packetsize);
+    TCPIP_ARENA_TABLE(arena, TcpIp_RxPoolNext   , sizes->rx_buffers);
+    TCPIP_ARENA_TABLE(arena, TcpIp_RxPoolLent   , sizes->rx_buffers);
+#endif
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+    TCPIP_ARENA_TABLE(arena, TcpIp_RxRings      , sizes->sockets);
+    TCPIP_ARENA_TABLE(arena, TcpIp_RxRingData   , sizes->sockets * TCPIP_CFG_RX_RING_SIZE);
+#endif
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_Zerocopy     , sizes->sockets);
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_TcpTx        , sizes->sockets);
+    TCPIP_ARENA_TABLE(arena, TcpIp_TcpTxData    , sizes->sockets * TCPIP_CFG_TCP_TX_BUFFER_SIZE);
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_TcpCoalesceData, sizes->sockets * TCPIP_CFG_TCP_COALESCE_SIZE);
+#endif
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+    TCPIP_ARENA_TABLE(arena, TcpIp_TxQueue      , TCPIP_CFG_TX_QUEUE_ENTRIES);
+    TCPIP_ARENA_TABLE(arena, TcpIp_TxQueueData  , TCPIP_CFG_TX_QUEUE_ENTRIES * sizes->packetsize);
+#endif
+}
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+/**
+ * @brief Size of transmit pool class, doubling from TCPIP_CFG_TX_POOL_MIN_SIZE up to the packet size
+ */
+static uint32 TcpIp_TxPool_ClassSize(uint32 packetsize, uint32 cls)
+{
+    uint32 size = (uint32)TCPIP_CFG_TX_POOL_MIN_SIZE << cls;
+    if (size > packetsize) {
+        size = packetsize;
+    }
+    return size;
+}
+#endif
+
+/**
+ * @brief Resolve the table sizes of a configuration, 0 in any field selects the default
+ */
+static Std_ReturnType TcpIp_Arena_Sizes(const TcpIp_ConfigType* config, TcpIp_ArenaSizesType* sizes)
+{
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+    uint32 cls;
+#endif
+
+    sizes->sockets     = TCPIP_CFG_MAX_SOCKETS;
+    sizes->packetsize  = TCPIP_CFG_MAX_PACKETSIZE;
+    sizes->controllers = TCPIP_CFG_MAX_CONTROLLER;
+    sizes->tx_buffers  = TCPIP_CFG_TX_POOL_BUFFERS;
+    sizes->rx_buffers  = TCPIP_CFG_RX_LOAN_BUFFERS;
+
+    if (config != NULL_PTR) {
+        if (config->max_sockets != 0u) {
+            sizes->sockets = config->max_sockets;
+        }
+        if (config->max_packetsize != 0u) {
+            sizes->packetsize = config->max_packetsize;
+        }
+        if (config->max_controller != 0u) {
+            sizes->controllers = config->max_controller;
+        }
+        if (config->tx_buffers != 0u) {
+            sizes->tx_buffers = config->tx_buffers;
+        }
+        if (config->rx_buffers != 0u) {
+            sizes->rx_buffers = config->rx_buffers;
+        }
+    }
+
+    /* receive buffers live on the stack, so the compile time size stays the limit */
+    if (sizes->packetsize > TCPIP_CFG_MAX_PACKETSIZE) {
+        return E_NOT_OK;
+    }
+    if (sizes->sockets >= TCPIP_SOCKETID_INVALID) {
+        return E_NOT_OK;
+    }
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    if (sizes->rx_buffers >= TCPIP_RX_POOL_NONE) {
+        return E_NOT_OK;
+    }
+#endif
+#if(TCPIP_CFG_ENABLE_SOCKET_GENERATION == STD_ON)
+    if (sizes->sockets > (1u << TCPIP_CFG_SOCKET_INDEX_BITS)) {
+        return E_NOT_OK;
+    }
+#endif
+
+    sizes->tx_classes = 0u;
+    sizes->tx_bytes   = 0u;
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+    if (sizes->tx_buffers > 0xffffu) {
+        return E_NOT_OK;
+    }
+    for (cls = 0u; cls < TCPIP_TX_POOL_CLASSES; ++cls) {
+        sizes->tx_bytes += TcpIp_TxPool_ClassSize(sizes->packetsize, cls);
+        sizes->tx_classes++;
+        if (TcpIp_TxPool_ClassSize(sizes->packetsize, cls) == sizes->packetsize) {
+            break;
+        }
+    }
+#endif
+    return E_OK;
+}
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+static void TcpIp_TxPool_Init(const TcpIp_ArenaSizesType* sizes)
+{
+    uint32 cls, index;
+    uint8* data = TcpIp_TxPoolData;
+
+    TcpIp_TxPoolClasses = (uint8)sizes->tx_classes;
+    TcpIp_TxPoolBuffers = (uint16)sizes->tx_buffers;
+    for (cls = 0u; cls < TcpIp_TxPoolClasses; ++cls) {
+        TcpIp_TxPoolType* p = &TcpIp_TxPool[cls];
+        p->base       = data;
+        p->free       = &TcpIp_TxPoolFree[cls * TcpIp_TxPoolBuffers];
+        p->size       = (uint16)TcpIp_TxPool_ClassSize(sizes->packetsize, cls);
+        p->available  = TcpIp_TxPoolBuffers;
+        p->in_use_max = 0u;
+        p->exhausted  = 0u;
+        for (index = 0u; index < TcpIp_TxPoolBuffers; ++index) {
+            p->free[index] = (uint16)index;
+        }
+        data += (uint32)p->size * TcpIp_TxPoolBuffers;
+    }
+}
+
+/**
+ * @brief Borrow the smallest free transmit buffer holding len bytes
+ * @return Buffer or NULL if every class large enough is exhausted
+ */
+static uint8* TcpIp_TxPool_Get(uint32 len, uint8* cls)
+{
+    uint8* buf = NULL;
+    uint8  c;
+
+    TCPIP_SOCKET_LOCK();
+    for (c = 0u; (c < TcpIp_TxPoolClasses) && (buf == NULL); ++c) {
+        TcpIp_TxPoolType* p = &TcpIp_TxPool[c];
+        if (p->size < len) {
+            continue;
+        }
+        if (p->available == 0u) {
+            p->exhausted++;
+            continue;
+        }
+        p->available--;
+        buf  = &p->base[(uint32)p->free[p->available] * p->size];
+        *cls = c;
+        if (TcpIp_TxPoolBuffers - p->available > p->in_use_max) {
+            p->in_use_max = TcpIp_TxPoolBuffers - p->available;
+        }
+    }
+    TCPIP_SOCKET_UNLOCK();
+    return buf;
+}
+
+static void TcpIp_TxPool_Put(uint8* buf, uint8 cls)
+{
+    TcpIp_TxPoolType* p = &TcpIp_TxPool[cls];
+
+    TCPIP_SOCKET_LOCK();
+    p->free[p->available] = (uint16)((uint32)(buf - p->base) / p->size);
+    p->available++;
+    TCPIP_SOCKET_UNLOCK();
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+static void TcpIp_RxPool_Init(const TcpIp_ArenaSizesType* sizes)
+{
+    uint32 index;
+
+    TcpIp_RxPoolBuffers = (uint16)sizes->rx_buffers;
+    for (index = 0u; index < TcpIp_RxPoolBuffers; ++index) {
+        TcpIp_RxPoolNext[index] = (uint16)(index + 1u);
+        TcpIp_RxPoolLent[index] = FALSE;
+    }
+    if (TcpIp_RxPoolBuffers > 0u) {
+        TcpIp_RxPoolNext[TcpIp_RxPoolBuffers - 1u] = TCPIP_RX_POOL_NONE;
+        TcpIp_RxPoolHead = 0u;
+    } else {
+        TcpIp_RxPoolHead = TCPIP_RX_POOL_NONE;
+    }
+    TcpIp_RxPoolInUse    = 0u;
+    TcpIp_RxPoolInUseMax = 0u;
+    TcpIp_RxPoolLoaned   = 0u;
+    TcpIp_RxPoolFallback = 0u;
+}
+
+/**
+ * @brief Take a receive buffer from the pool, callable from any thread
+ * @return Buffer of TcpIp_PacketSize bytes or NULL if all are lent out
+ */
+static uint8* TcpIp_RxPool_Get(void)
+{
+    uint32 head = __atomic_load_n(&TcpIp_RxPoolHead, __ATOMIC_ACQUIRE);
+    uint32 next, in_use, in_use_max;
+    uint16 index;
+
+    do {
+        index = (uint16)(head & 0xffffu);
+        if (index == TCPIP_RX_POOL_NONE) {
+            __atomic_fetch_add(&TcpIp_RxPoolFallback, 1u, __ATOMIC_RELAXED);
+            return NULL;
+        }
+        next = (head & 0xffff0000u) + 0x10000u + __atomic_load_n(&TcpIp_RxPoolNext[index], __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&TcpIp_RxPoolHead, &head, next, TRUE, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    in_use     = __atomic_add_fetch(&TcpIp_RxPoolInUse, 1u, __ATOMIC_RELAXED);
+    in_use_max = __atomic_load_n(&TcpIp_RxPoolInUseMax, __ATOMIC_RELAXED);
+    while ((in_use > in_use_max)
+        && !__atomic_compare_exchange_n(&TcpIp_RxPoolInUseMax, &in_use_max, in_use, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        /* retry with the updated maximum */
+    }
+    return &TcpIp_RxPoolData[(uint32)index * TcpIp_PacketSize];
+}
+
+static void TcpIp_RxPool_Put(uint16 index)
+{
+    uint32 head = __atomic_load_n(&TcpIp_RxPoolHead, __ATOMIC_RELAXED);
+    uint32 next;
+
+    do {
+        __atomic_store_n(&TcpIp_RxPoolNext[index], (uint16)(head & 0xffffu), __ATOMIC_RELAXED);
+        next = (head & 0xffff0000u) + 0x10000u + index;
+    } while (!__atomic_compare_exchange_n(&TcpIp_RxPoolHead, &head, next, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    __atomic_fetch_sub(&TcpIp_RxPoolInUse, 1u, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Index of a pooled receive buffer
+ * @return E_OK:     buf is the start of a pooled buffer
+ *         E_NOT_OK: buf is not from the pool
+ */
+static Std_ReturnType TcpIp_RxPool_Index(const uint8* buf, uint16* index)
+{
+    uintptr_t offset = (uintptr_t)buf - (uintptr_t)TcpIp_RxPoolData;
+
+    if ((buf < TcpIp_RxPoolData) || (offset >= (uintptr_t)TcpIp_RxPoolBuffers * TcpIp_PacketSize)) {
+        return E_NOT_OK;
+    }
+    if ((offset % TcpIp_PacketSize) != 0u) {
+        return E_NOT_OK;
+    }
+    *index = (uint16)(offset / TcpIp_PacketSize);
+    return E_OK;
+}
+
+/**
+ * @brief Return a receive buffer lent to upper layer by SoAd_RxIndicationLoan
+ * @param[in] buf Buffer pointer as given in the indication
+ * @return E_OK:     Buffer returned to the pool
+ *         E_NOT_OK: buf was not a lent buffer or was already returned
+ */
+Std_ReturnType TcpIp_RxRelease(uint8* buf)
+{
+    uint16 index;
+
+    if (TcpIp_RxPool_Index(buf, &index) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_RXRELEASE, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    /* a second release would link the buffer into the free list twice */
+    if (!__atomic_exchange_n(&TcpIp_RxPoolLent[index], FALSE, __ATOMIC_ACQ_REL)) {
+        TCPIP_DET_ERROR(TCPIP_API_RXRELEASE, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    TcpIp_RxPool_Put(index);
+    return E_OK;
+}
+
+/**
+ * @brief Get the usage of the receive buffer pool
+ * @param[out] stats Usage of the pool
+ */
+void TcpIp_GetRxPoolStats(TcpIp_RxPoolStatsType* stats)
+{
+    stats->buffers    = TcpIp_RxPoolBuffers;
+    stats->in_use     = __atomic_load_n(&TcpIp_RxPoolInUse   , __ATOMIC_RELAXED);
+    stats->in_use_max = __atomic_load_n(&TcpIp_RxPoolInUseMax, __ATOMIC_RELAXED);
+    stats->loaned     = __atomic_load_n(&TcpIp_RxPoolLoaned  , __ATOMIC_RELAXED);
+    stats->fallback   = __atomic_load_n(&TcpIp_RxPoolFallback, __ATOMIC_RELAXED);
+}
+#endif
+
+/**
+ * @brief Get the usage of one class of the shared transmit buffer pool
+ * @param[in]  cls   Class index, classes are ordered by increasing buffer size
+ * @param[out] stats Usage of the class
+ * @return E_OK:     stats was filled
+ *         E_NOT_OK: No such class
+ */
+Std_ReturnType TcpIp_GetTxPoolStats(uint8 cls, TcpIp_TxPoolStatsType* stats)
+{
+    TCPIP_DET_CHECK_RET(stats != NULL_PTR, TCPIP_API_GETTXPOOLSTATS, TCPIP_E_PARAM_POINTER);
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+    if (cls < TcpIp_TxPoolClasses) {
+        TcpIp_TxPoolType* p = &TcpIp_TxPool[cls];
+        TCPIP_SOCKET_LOCK();
+        stats->size       = p->size;
+        stats->buffers    = TcpIp_TxPoolBuffers;
+        stats->in_use     = TcpIp_TxPoolBuffers - p->available;
+        stats->in_use_max = p->in_use_max;
+        stats->exhausted  = p->exhausted;
+        TCPIP_SOCKET_UNLOCK();
+        return E_OK;
+    }
+#else
+    (void)cls;
+#endif
+    return E_NOT_OK;
+}
+
+#if(TCPIP_CFG_ENABLE_SYSCALL_STATS == STD_ON)
+/**
+ * @brief Read the system call counters, they restart from zero at TcpIp_Init
+ * @param[out] stats Snapshot of the counters
+ */
+void TcpIp_GetSyscallStats(TcpIp_SyscallStatsType* stats)
+{
+    stats->get_socket       = __atomic_load_n(&TcpIp_SyscallStats.get_socket      , __ATOMIC_RELAXED);
+    stats->bind             = __atomic_load_n(&TcpIp_SyscallStats.bind            , __ATOMIC_RELAXED);
+    stats->tcp_connect      = __atomic_load_n(&TcpIp_SyscallStats.tcp_connect     , __ATOMIC_RELAXED);
+    stats->tcp_listen       = __atomic_load_n(&TcpIp_SyscallStats.tcp_listen      , __ATOMIC_RELAXED);
+    stats->tcp_transmit     = __atomic_load_n(&TcpIp_SyscallStats.tcp_transmit    , __ATOMIC_RELAXED);
+    stats->udp_transmit     = __atomic_load_n(&TcpIp_SyscallStats.udp_transmit    , __ATOMIC_RELAXED);
+    stats->change_parameter = __atomic_load_n(&TcpIp_SyscallStats.change_parameter, __ATOMIC_RELAXED);
+    stats->close            = __atomic_load_n(&TcpIp_SyscallStats.close           , __ATOMIC_RELAXED);
+    stats->wakeup           = __atomic_load_n(&TcpIp_SyscallStats.wakeup          , __ATOMIC_RELAXED);
+    stats->events           = __atomic_load_n(&TcpIp_SyscallStats.events          , __ATOMIC_RELAXED);
+    stats->main_function    = __atomic_load_n(&TcpIp_SyscallStats.main_function   , __ATOMIC_RELAXED);
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_ACCEPT_STATS == STD_ON)
+/**
+ * @brief Read the accept counters, they restart from zero at TcpIp_Init
+ * @param[out] stats Snapshot of the counters
+ */
+void TcpIp_GetAcceptStats(TcpIp_AcceptStatsType* stats)
+{
+    stats->accepted         = __atomic_load_n(&TcpIp_AcceptStats.accepted        , __ATOMIC_RELAXED);
+    stats->dropped          = __atomic_load_n(&TcpIp_AcceptStats.dropped         , __ATOMIC_RELAXED);
+    stats->budget_exhausted = __atomic_load_n(&TcpIp_AcceptStats.budget_exhausted, __ATOMIC_RELAXED);
+    stats->backlog_full     = __atomic_load_n(&TcpIp_AcceptStats.backlog_full    , __ATOMIC_RELAXED);
+    stats->backlog_max      = __atomic_load_n(&TcpIp_AcceptStats.backlog_max     , __ATOMIC_RELAXED);
+}
+#endif
+
+/**
+ * @brief Place the tables in the configured arena, or the built in one if none is given
+ */
+static Std_ReturnType TcpIp_Arena_Setup(const TcpIp_ConfigType* config)
+{
+    TcpIp_ArenaType      arena;
+    TcpIp_ArenaSizesType sizes;
+    uint8*               base = (uint8*)TcpIp_StaticArena;
+    uint32               size = sizeof(TcpIp_StaticArena);
+    uint32               skip;
+
+    TcpIp_SocketCount = 0u;
+    TcpIp_CtrlCount   = 0u;
+
+    if (TcpIp_Arena_Sizes(config, &sizes) != E_OK) {
+        return E_NOT_OK;
+    }
+
+    if ((config != NULL_PTR) && (config->arena != NULL)) {
+        base = (uint8*)config->arena;
+        size = config->arena_size;
+    }
+
+    skip = (uint32)((TCPIP_ARENA_ALIGN - ((uintptr_t)base % TCPIP_ARENA_ALIGN)) % TCPIP_ARENA_ALIGN);
+    if (size < skip) {
+        return E_NOT_OK;
+    }
+
+    arena.base = NULL;
+    arena.used = 0u;
+    TcpIp_Arena_Layout(&arena, &sizes);
+    if (arena.used > size - skip) {
+        return E_NOT_OK;
+    }
+
+    arena.base = base + skip;
+    arena.used = 0u;
+    TcpIp_Arena_Layout(&arena, &sizes);
+
+    TcpIp_SocketCount = (TcpIp_SocketIdType)sizes.sockets;
+    TcpIp_PacketSize  = (uint16)sizes.packetsize;
+    TcpIp_CtrlCount   = (uint8)sizes.controllers;
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+    TcpIp_TxPool_Init(&sizes);
+#endif
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    TcpIp_RxPool_Init(&sizes);
+#endif
+    return E_OK;
+}
+
+uint32 TcpIp_GetArenaSize(const TcpIp_ConfigType* config)
+{
+    TcpIp_ArenaType      arena;
+    TcpIp_ArenaSizesType sizes;
+
+    if (TcpIp_Arena_Sizes(config, &sizes) != E_OK) {
+        return 0u;
+    }
+
+    arena.base = NULL;
+    arena.used = 0u;
+    TcpIp_Arena_Layout(&arena, &sizes);
+    /* room to align an arbitrary start address */
+    return arena.used + TCPIP_ARENA_ALIGN - 1u;
+}
+
+/**
+ * @brief This service initializes the TCP/IP Stack.
+ *
+ * TcpIp_Init may not block the start-up process for an indefinite amount of time.
+ * @note The call of this service is mandatory before using the TcpIp instance for further processing.
+ * @param[in] config Pointer to the configuration data of the TcpIp module
+ */
+void TcpIp_Init(const TcpIp_ConfigType* config)
+{
+    TcpIp_SocketIdType id;
+    uint8              ctrl;
+    TcpIp_Config = config;
+
+    if (TcpIp_Arena_Setup(config) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_INIT, TCPIP_E_INIT_FAILED);
+        return;
+    }
+
+#if(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+    if (TcpIp_EpollFd != -1) {
+        close(TcpIp_EpollFd);
+    }
+    TcpIp_EpollFd    = epoll_create1(EPOLL_CLOEXEC);
+    TcpIp_EpollCount = 0;
+    TcpIp_EpollNext  = 0;
+    if (TcpIp_EpollFd == -1) {
+        TCPIP_DET_ERROR(TCPIP_API_INIT, TCPIP_E_INIT_FAILED);
+    }
+#endif
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    if (TcpIp_Uring_Setup() != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_INIT, TCPIP_E_INIT_FAILED);
+    }
+#endif
+
+#if(TCPIP_WAKEUP_FD == STD_ON)
+    if (TcpIp_WakeupFd != -1) {
+        close(TcpIp_WakeupFd);
+    }
+    TcpIp_WakeupFd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (TcpIp_WakeupFd == -1) {
+        TCPIP_DET_ERROR(TCPIP_API_INIT, TCPIP_E_INIT_FAILED);
+    } else {
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+        TcpIp_Uring_ArmWakeup();
+#elif(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+        struct epoll_event ev;
+        ev.events   = EPOLLIN;
+        ev.data.u64 = TCPIP_EPOLL_WAKEUP;
+        (void)epoll_ctl(TcpIp_EpollFd, EPOLL_CTL_ADD, TcpIp_WakeupFd, &ev);
+#else
+        TcpIp_PollFds[TCPIP_WAKEUP_INDEX].fd      = TcpIp_WakeupFd;
+        TcpIp_PollFds[TCPIP_WAKEUP_INDEX].events  = POLLIN;
+        TcpIp_PollFds[TCPIP_WAKEUP_INDEX].revents = 0;
+#endif
+    }
+#endif
+
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TcpIp_Timer_Init();
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    TcpIp_TxCorked  = TCPIP_SOCKETID_INVALID;
+#endif
+
+    TcpIp_FreeHead  = 0u;
+    TcpIp_FreeCount = 0u;
+    for (id = 0u; id < TcpIp_SocketCount; ++id) {
+        TcpIp_InitSocket(id);
+        TcpIp_FreeSocket_Push(id);
+    }
+
+    for (ctrl = 0u; ctrl < TcpIp_CtrlCount; ++ctrl) {
+        TcpIp_Ctrl[ctrl].state = TCPIP_STATE_OFFLINE;
+    }
+
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    TcpIp_Worker_Start();
+#endif
+
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+    TcpIp_TxQueue_Init();
+#endif
+
+#if(TCPIP_CFG_ENABLE_SYSCALL_STATS == STD_ON)
+    memset(&TcpIp_SyscallStats, 0, sizeof(TcpIp_SyscallStats));
+#endif
+#if(TCPIP_CFG_ENABLE_ACCEPT_STATS == STD_ON)
+    memset(&TcpIp_AcceptStats, 0, sizeof(TcpIp_AcceptStats));
+#endif
+}
+
+/**
+ * @brief By this API service the TCP/IP stack is requested to change the TcpIp state of the
+ *        communication network identified by EthIf controller index.
+ * @param[in] id    EthIf controller index to identify the communication network
+ *                  where the TcpIp state is requested.
+ * @param{in] state Requested TcpIp state
+ * @return E_OK:     Service accepted
+ *         E_NOT_OK: Service denied
+ *
+ * @req SWS_TCPIP_00071-TODO
+ * @req SWS_TCPIP_00072
+ * @req SWS_TCPIP_00074-TODO
+ * @req SWS_TCPIP_00089
+ */
+Std_ReturnType TcpIp_RequestComMode(
+        uint8           id,
+        TcpIp_StateType state
+    )
+{
+    Std_ReturnType res;
+    if (id < TcpIp_CtrlCount) {
+        switch (state) {
+            case TCPIP_STATE_OFFLINE: {
+                TcpIp_SocketIdType index;
+                for (index = 0u; index < TcpIp_SocketCount; ++index) {
+                    if (TcpIp_Sockets[index].state != TCPIP_SOCKET_STATE_UNUSED) {
+                        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+                    }
+                }
+                TcpIp_Ctrl[id].state = state;
+                res = E_OK;
+                break;
+            }
+
+            case TCPIP_STATE_SHUTDOWN:
+            case TCPIP_STATE_STARTUP: {
+                TCPIP_DET_ERROR(TCPIP_API_REQUESTCOMMODE, TCPIP_E_INV_ARG);
+                res = E_NOT_OK;
+                break;
+            }
+            default: {
+                TcpIp_Ctrl[id].state = state;
+                res = E_OK;
+                break;
+            }
+        }
+    } else {
+        res = E_NOT_OK;
+    }
+    return res;
+}
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+/**
+ * @brief Hand buffered data to the kernel as far as it takes it, caller holds TCPIP_TCP_TX_LOCK
+ * @return E_NOT_OK: The socket failed, caller hands it to TcpIp_TcpTx_Failed once unlocked
+ */
+static Std_ReturnType TcpIp_TcpTx_Flush(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType* s    = &TcpIp_Sockets[index];
+    TcpIp_TcpTxType*  t    = &TcpIp_TcpTx[index];
+    uint8*            data = &TcpIp_TcpTxData[(uint32)index * TCPIP_CFG_TCP_TX_BUFFER_SIZE];
+    uint32            head = t->head;
+    uint32            tail = t->tail;
+    uint32            offset, len;
+    Std_ReturnType    res  = E_OK;
+    int               v;
+
+    while (head != tail) {
+        offset = head & (TCPIP_CFG_TCP_TX_BUFFER_SIZE - 1u);
+        len    = tail - head;
+        if (len > TCPIP_CFG_TCP_TX_BUFFER_SIZE - offset) {
+            len = TCPIP_CFG_TCP_TX_BUFFER_SIZE - offset;
+        }
+
+        TCPIP_SYSCALL_COUNT(tcp_transmit);
+        v = send(s->fd, &data[offset], len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (v == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                res = E_NOT_OK;
+            }
+            break;
+        }
+        head += (uint32)v;
+    }
+    __atomic_store_n(&t->head, head, __ATOMIC_RELEASE);
+
+    if ((head == tail) && t->shutdown) {
+        t->shutdown = FALSE;
+        TCPIP_SYSCALL_COUNT(close);
+        (void)shutdown(s->fd, SHUT_WR);
+    }
+
+    TcpIp_SocketEvents_Update(index, TcpIp_SocketEvents_Stream(index));
+    return res;
+}
+
+/**
+ * @brief Buffered data can't be delivered once a send failed, the stream is broken
+ */
+static void TcpIp_TcpTx_Failed(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketStateType state = TcpIp_Sockets[index].state;
+
+    TCPIP_DET_ERROR(TCPIP_API_TCPTRANSMIT, TCPIP_E_NOTCONN);
+    if ((state == TCPIP_SOCKET_STATE_CONNECTED) || (state == TCPIP_SOCKET_STATE_SHUTDOWN)) {
+        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+    }
+}
+
+/**
+ * @brief Send what the kernel takes of the buffer, a failure closes the socket
+ */
+static void TcpIp_TcpTx_Poll(TcpIp_SocketIdType index)
+{
+    Std_ReturnType res;
+
+    TCPIP_TCP_TX_LOCK(index);
+    res = TcpIp_TcpTx_Flush(index);
+    TCPIP_TCP_TX_UNLOCK(index);
+    if (res != E_OK) {
+        TcpIp_TcpTx_Failed(index);
+    }
+}
+
+/**
+ * @brief Defer the shutdown of a socket until its buffer has been sent
+ * @return TRUE when there was data left, the shutdown is then done by TcpIp_TcpTx_Flush
+ */
+static boolean TcpIp_TcpTx_Linger(TcpIp_SocketIdType index)
+{
+    TcpIp_TcpTxType* t = &TcpIp_TcpTx[index];
+    boolean          res;
+
+    TCPIP_TCP_TX_LOCK(index);
+    res = (t->head != t->tail);
+    if (res) {
+        t->shutdown = TRUE;
+    }
+    TCPIP_TCP_TX_UNLOCK(index);
+    return res;
+}
+
+/**
+ * @brief Take data for transmission without blocking, whatever the kernel does not take is buffered
+ */
+static Std_ReturnType TcpIp_TcpTx_Transmit(TcpIp_SocketIdType index, const uint8* data, uint32 available, boolean force)
+{
+    TcpIp_SocketType* s    = &TcpIp_Sockets[index];
+    TcpIp_TcpTxType*  t    = &TcpIp_TcpTx[index];
+    uint8*            base = &TcpIp_TcpTxData[(uint32)index * TCPIP_CFG_TCP_TX_BUFFER_SIZE];
+    BufReq_ReturnType r;
+    Std_ReturnType    res  = E_OK;
+    uint32            tail, offset, len, done;
+    int               v;
+
+    /* same as the blocking path, without force upper layer is asked for one chunk only */
+    if ((data == NULL) && !force && (available > TcpIp_PacketSize)) {
+        available = TcpIp_PacketSize;
+    }
+
+    TCPIP_TCP_TX_LOCK(index);
+    tail = t->tail;
+    if (t->shutdown || (available > TCPIP_CFG_TCP_TX_BUFFER_SIZE - (tail - t->head))) {
+        TCPIP_TCP_TX_UNLOCK(index);
+        TCPIP_DET_ERROR(TCPIP_API_TCPTRANSMIT, TCPIP_E_NOBUFS);
+        return E_NOT_OK;
+    }
+
+    if (data != NULL) {
+        if (t->head == tail) {
+            /* nothing queued ahead, try the kernel first and only buffer the rest */
+            TCPIP_SYSCALL_COUNT(tcp_transmit);
+            v = send(s->fd, data, available, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (v > 0) {
+                data      += v;
+                available -= (uint32)v;
+            } else if ((v == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+                TCPIP_TCP_TX_UNLOCK(index);
+                TcpIp_TcpTx_Failed(index);
+                return E_NOT_OK;
+            }
+        }
+        for (done = 0u; done < available; done += len) {
+            offset = (tail + done) & (TCPIP_CFG_TCP_TX_BUFFER_SIZE - 1u);
+            len    = available - done;
+            if (len > TCPIP_CFG_TCP_TX_BUFFER_SIZE - offset) {
+                len = TCPIP_CFG_TCP_TX_BUFFER_SIZE - offset;
+            }
+            memcpy(&base[offset], &data[done], len);
+        }
+        __atomic_store_n(&t->tail, tail + available, __ATOMIC_RELEASE);
+        available = 0u;
+    }
+    TCPIP_TCP_TX_UNLOCK(index);
+
+    /* the space past tail is ours, the flush only takes from head */
+    for (done = 0u; done < available; done += len) {
+        offset = (tail + done) & (TCPIP_CFG_TCP_TX_BUFFER_SIZE - 1u);
+        len    = available - done;
+        if (len > TCPIP_CFG_TCP_TX_BUFFER_SIZE - offset) {
+            len = TCPIP_CFG_TCP_TX_BUFFER_SIZE - offset;
+        }
+        if (len > TcpIp_PacketSize) {
+            len = TcpIp_PacketSize;
+        }
+        r = SoAd_CopyTxData(TCPIP_SOCKET_ID(index), &base[offset], (uint16)len);
+        if (r == BUFREQ_E_BUSY) {
+            break;
+        } else if (r != BUFREQ_OK) {
+            res = E_NOT_OK;
+            break;
+        }
+    }
+
+    TCPIP_TCP_TX_LOCK(index);
+    if (data == NULL) {
+        __atomic_store_n(&t->tail, tail + done, __ATOMIC_RELEASE);
+    }
+    if (TcpIp_TcpTx_Flush(index) != E_OK) {
+        TCPIP_TCP_TX_UNLOCK(index);
+        TcpIp_TcpTx_Failed(index);
+        return E_NOT_OK;
+    }
+    TCPIP_TCP_TX_UNLOCK(index);
+    return res;
+}
+#endif
+
+/**
+ * @brief By this API service the TCP/IP stack is requested to close the socket and release all related resources.
+ * @param[in] Abort TRUE:  connection will immediately be terminated by sending a
  *                         RST-Segment and releasing all related resources.
  *                  FALSE: connection will be terminated after performing a regular
  *                         connection termination handshake and releasing all related
@@ -304,664 +2789,3014 @@ Std_ReturnType TcpIp_RequestComMode(
  * @return    E_OK:     The request has been accepted
  *            E_NOT_OK: The request has not been accepted.
  *
- * @req SWS_TCPIP_00017
- * @req SWS_TCPIP_00109
- * @req SWS_TCPIP_00110
+ * @req SWS_TCPIP_00017
+ * @req SWS_TCPIP_00109
+ * @req SWS_TCPIP_00110
+ */
+Std_ReturnType TcpIp_Close(
+        TcpIp_SocketIdType          id,
+        boolean                     abort
+    )
+{
+    TcpIp_SocketType* s;
+    Std_ReturnType   res;
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_CLOSE, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    if (s->protocol == TCPIP_IPPROTO_TCP) {
+        if (abort) {
+            TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
+            res = E_OK;
+        } else {
+            if (s->state == TCPIP_SOCKET_STATE_CONNECTED) {
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+                if (TcpIp_UringSockets[id].tx_head != TCPIP_URING_TX_NONE) {
+                    /* shutdown once queued data has been handed to the kernel */
+                    TcpIp_UringSockets[id].tx_shutdown = TRUE;
+                    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_SHUTDOWN);
+                    res = E_OK;
+                } else
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+                if (TcpIp_TcpTx_Linger(id)) {
+                    /* shutdown once buffered data has been handed to the kernel */
+                    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_SHUTDOWN);
+                    res = E_OK;
+                } else
+#endif
+                {
+                    TCPIP_SYSCALL_COUNT(close);
+                    if (shutdown(s->fd, SHUT_WR) == 0) {
+                        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_SHUTDOWN);
+                        res = E_OK;
+                    } else {
+                        res = E_NOT_OK;
+                    }
+                }
+            } else {
+                TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
+                res = E_OK;
+            }
+        }
+    } else if (s->protocol == TCPIP_IPPROTO_UDP) {
+        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
+        res = E_OK;
+    } else {
+        res = E_NOT_OK;
+    }
+
+    return res;
+}
+
+/**
+ * @brief By this API service the TCP/IP stack is requested to bind a UDP or TCP socket to a local resource.
+ * @param[in] id          Socket identifier of the related local socket resource.
+ * @param[in] local_addr  IP address identifier representing the local IP address and EthIf
+ *                        controller to bind the socket to.
+ *                        Note: to listen to all EthIf controller, TCPIP_LOCALADDRID_ANY
+ *                              has to be specified as LocalAddrId.
+ *                        Note: to listen on any IP addresss of a EthIf controller, the
+ *                              configuration parameter TcpIpStaticIpAddress referenced by
+ *                              LocalAddrId must be set to "ANY". The remote IP address of an
+ *                              incoming packet has no effect then.
+ *                        In case the socket shall be used as client socket, the IP address
+ *                              and EthIf controller represented by LocalAddrId is used for
+ *                              transmission.
+ *                        Note: for an automatic selection of the Local IP address and EthIf
+ *                              Controller, TCPIP_LOCALADDRID_ANY has to be specified as
+ *                              LocalAddrId
+ * @param[in,out] port    Pointer to memory where the local port to which the socket shall
+ *                        be bound is specified. In case the parameter is specified as
+ *                        TCPIP_PORT_ANY, the TCP/IP stack shall choose the local port
+ *                        automatically from the range 49152 to 65535 and shall update the
+ *                        parameter to the chosen value.
+ *
+ * @req SWS_TCPIP_00015
+ *
+ */
+Std_ReturnType TcpIp_Bind(
+        TcpIp_SocketIdType          id,
+        TcpIp_LocalAddrIdType       local_addr,
+        uint16*                     port
+    )
+{
+    TcpIp_SocketType* s;
+    Std_ReturnType    res;
+    union {
+        struct sockaddr_in  in;
+        struct sockaddr_in6 in6;
+    } addr = {};
+    socklen_t len;
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_BIND, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    if (local_addr != TCPIP_LOCALADDRID_ANY) {
+        /** @req SWS_TCPIP_00111-TODO */
+        /** @req SWS_TCPIP_00147-TODO */
+        res = E_NOT_OK;
+        goto done;
+    }
+
+    if (s->domain == TCPIP_AF_INET) {
+        addr.in.sin_family   = AF_INET;
+        addr.in.sin_port     = *port;
+        len = sizeof(addr.in);
+    } else if (s->domain == TCPIP_AF_INET6) {
+        addr.in6.sin6_family = AF_INET6;
+        addr.in6.sin6_port   = *port;
+        len = sizeof(addr.in6);
+    } else {
+        res = E_NOT_OK;
+        goto done;
+    }
+
+    TCPIP_SYSCALL_COUNT(bind);
+    if (bind(s->fd, (const struct sockaddr*)&addr, len) != 0) {
+        if (errno == EADDRINUSE) {
+            /** @req SWS_TCPIP_00146 */
+            TCPIP_DET_ERROR(TCPIP_API_BIND, TCPIP_E_ADDRINUSE);
+        }
+        res = E_NOT_OK;
+        goto done;
+    }
+
+    len = sizeof(addr);
+    TCPIP_SYSCALL_COUNT(bind);
+    if (getsockname(s->fd, (struct sockaddr*)&addr, &len) != 0) {
+        res = E_NOT_OK;
+        goto done;
+    }
+    if (addr.in.sin_family == AF_INET) {
+        *port = addr.in.sin_port;
+    } else if (addr.in6.sin6_family == AF_INET6) {
+        *port = addr.in6.sin6_port;
+    } else {
+        res = E_NOT_OK;
+        goto done;
+    }
+
+    res = E_OK;
+    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_BOUND);
+
+done:
+    return res;
+}
+
+/**
+ * @brief By this API service the TCP/IP stack is requested to establish a TCP connection to the configured peer.
+ * @warn Reentrant for different SocketIds. Non reentrant for the same SocketId.
+ * @info Asynchronous
+ * @req  SWS_TCPIP_00022
+ *
+ * @param[in] id     Socket identifier of the related local socket resource.
+ * @param[in] remote IP address and port of the remote host to connect to.
+ * @return E_OK:     The request has been accepted
+ *         E_NOT_OK: The request has not been accepted, e.g. connection
+ *                   is already established or no route to destination specified by
+ *                   remoteAddrPtr found.
+ */
+Std_ReturnType TcpIp_TcpConnect(
+        TcpIp_SocketIdType          id,
+        const TcpIp_SockAddrType*   remote
+    )
+{
+    TcpIp_SocketType* s;
+    Std_ReturnType    res;
+
+    struct sockaddr_storage  addr;
+    socklen_t                addr_len;
+
+    TCPIP_DET_CHECK_RET(remote != NULL_PTR, TCPIP_API_TCPCONNECT, TCPIP_E_PARAM_POINTER);
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPCONNECT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    if (remote->domain != s->domain) {
+        return E_NOT_OK;
+    }
+
+    if (TcpIp_GetBsdSockaddrFromSocketAddr(&addr, &addr_len, remote) != E_OK) {
+        return E_NOT_OK;
+    }
+
+    TCPIP_SYSCALL_COUNT(tcp_connect);
+    int v = connect(s->fd, (const struct sockaddr*)&addr, addr_len);
+    if (v != 0) {
+        v = errno;
+    }
+
+    if (v == 0) {
+        (void)TcpIp_GetSockaddrFromBsdSocketAddr(&TcpIp_Peers[id], (const struct sockaddr*)&addr);
+        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_CONNECTED);
+    } else if(v == EINPROGRESS) {
+        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_CONNECTING);
+    } else {
+        return E_NOT_OK;
+    }
+
+    return E_OK;
+}
+
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+/**
+ * @brief Options a shard takes over from its listening socket, as set by TcpIp_ChangeParameter
+ */
+static const struct {
+    int family; /**< address family the option applies to, AF_UNSPEC for any */
+    int level;
+    int name;
+} TcpIp_ShardOptions[] = {
+    { AF_UNSPEC, SOL_SOCKET  , SO_RCVBUF         },
+    { AF_UNSPEC, SOL_SOCKET  , SO_PRIORITY       },
+    { AF_UNSPEC, SOL_SOCKET  , SO_KEEPALIVE      },
+    { AF_UNSPEC, IPPROTO_TCP , TCP_NODELAY       },
+    { AF_UNSPEC, IPPROTO_TCP , TCP_KEEPIDLE      },
+    { AF_UNSPEC, IPPROTO_TCP , TCP_KEEPCNT       },
+    { AF_UNSPEC, IPPROTO_TCP , TCP_KEEPINTVL     },
+    { AF_INET  , IPPROTO_IP  , IP_TTL            },
+    { AF_INET6 , IPPROTO_IPV6, IPV6_UNICAST_HOPS },
+};
+
+#if(TCPIP_CFG_ENABLE_SHARD_AFFINITY == STD_ON)
+/**
+ * @brief CPU a worker is pinned to, shards of that worker take connections received on it
+ */
+static int TcpIp_Shard_Cpu(uint32 worker)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        cpus = 1;
+    }
+    return (int)(worker % (uint32)cpus);
+}
+#endif
+
+/**
+ * @brief Worker that runs a shard and the connections accepted from it
+ */
+static uint16 TcpIp_Shard_Home(uint16 shard)
+{
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    return (uint16)(shard % TCPIP_CFG_WORKER_THREADS);
+#else
+    return shard;
+#endif
+}
+
+/**
+ * @brief Open one more kernel socket on the address of a listening socket
+ * @param[in] index    Listening socket
+ * @param[in] shard    Number of the shard, the listening socket itself is shard 0
+ * @param[in] addr     Local address of the listening socket
+ * @param[in] len      Length of addr
+ * @param[in] channels Backlog of the shard
+ */
+static Std_ReturnType TcpIp_ListenShards_Add(TcpIp_SocketIdType index, uint16 shard, const struct sockaddr_storage* addr, socklen_t len, uint16 channels)
+{
+    TcpIp_SocketType*  s  = &TcpIp_Sockets[index];
+    TcpIp_SocketIdType id = TCPIP_SOCKETID_INVALID;
+    TcpIp_OsSocketType fd;
+    socklen_t          vlen;
+    uint32             i;
+    int                v;
+
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    fd = socket(addr->ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == INVALID_SOCKET) {
+        goto cleanup;
+    }
+
+    for (i = 0u; i < sizeof(TcpIp_ShardOptions) / sizeof(TcpIp_ShardOptions[0]); ++i) {
+        if ((TcpIp_ShardOptions[i].family != AF_UNSPEC) && (TcpIp_ShardOptions[i].family != addr->ss_family)) {
+            continue;
+        }
+        vlen = sizeof(v);
+        TCPIP_SYSCALL_COUNT(tcp_listen);
+        if (getsockopt(s->fd, TcpIp_ShardOptions[i].level, TcpIp_ShardOptions[i].name, &v, &vlen) != 0) {
+            continue;
+        }
+        if (TcpIp_ShardOptions[i].name == SO_RCVBUF) {
+            /* the kernel reports twice the size asked for */
+            v = v / 2;
+        }
+        TCPIP_SYSCALL_COUNT(tcp_listen);
+        (void)setsockopt(fd, TcpIp_ShardOptions[i].level, TcpIp_ShardOptions[i].name, &v, sizeof(v));
+    }
+
+    v = 1;
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &v, sizeof(v)) != 0) {
+        goto cleanup;
+    }
+#if(TCPIP_CFG_ENABLE_SHARD_AFFINITY == STD_ON)
+    v = TcpIp_Shard_Cpu(TcpIp_Shard_Home(shard));
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    (void)setsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &v, sizeof(v));
+#endif
+
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    if (bind(fd, (const struct sockaddr*)addr, len) != 0) {
+        goto cleanup;
+    }
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    if (listen(fd, channels) != 0) {
+        goto cleanup;
+    }
+
+    if (TcpIp_AllocSocket(s->domain, s->protocol, &id) != E_OK) {
+        goto cleanup;
+    }
+    TcpIp_Sockets[id].fd          = fd;
+    TcpIp_Sockets[id].shard_owner = index;
+    TcpIp_Sockets[id].shard_next  = s->shard_next;
+    TcpIp_Sockets[id].shard_home  = TcpIp_Shard_Home(shard);
+    s->shard_next                 = id;
+    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_LISTEN);
+    return E_OK;
+
+cleanup:
+    if (fd != INVALID_SOCKET) {
+        TCPIP_SYSCALL_COUNT(tcp_listen);
+        closesocket(fd);
+    }
+    return E_NOT_OK;
+}
+
+/**
+ * @brief Open the shards of a listening socket
+ *
+ * The socket keeps listening on fewer shards, down to itself only, if
+ * sockets or slots run out.
+ */
+static void TcpIp_ListenShards_Open(TcpIp_SocketIdType index, uint16 channels)
+{
+    TcpIp_SocketType*       s   = &TcpIp_Sockets[index];
+    struct sockaddr_storage addr;
+    socklen_t               len = sizeof(addr);
+    uint16                  shard;
+
+    s->shard_home = TcpIp_Shard_Home(0u);
+#if(TCPIP_CFG_ENABLE_SHARD_AFFINITY == STD_ON)
+    {
+        int v = TcpIp_Shard_Cpu(s->shard_home);
+        TCPIP_SYSCALL_COUNT(tcp_listen);
+        (void)setsockopt(s->fd, SOL_SOCKET, SO_INCOMING_CPU, &v, sizeof(v));
+    }
+#endif
+
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    if (getsockname(s->fd, (struct sockaddr*)&addr, &len) != 0) {
+        return;
+    }
+
+    for (shard = 1u; shard < TCPIP_CFG_LISTEN_SHARDS; ++shard) {
+        if (TcpIp_ListenShards_Add(index, shard, &addr, len, channels) != E_OK) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Close the shards of a listening socket, they are unknown to the upper layer
+ */
+static void TcpIp_ListenShards_Close(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketIdType shard = TcpIp_Sockets[index].shard_next;
+
+    TcpIp_Sockets[index].shard_next = TCPIP_SOCKETID_INVALID;
+    while (shard != TCPIP_SOCKETID_INVALID) {
+        TcpIp_SocketIdType next = TcpIp_Sockets[shard].shard_next;
+        TcpIp_SocketState_Enter(shard, TCPIP_SOCKET_STATE_UNUSED);
+        shard = next;
+    }
+}
+#endif
+
+/**
+ * @brief By this API service the TCP/IP stack is requested to listen on the TCP socket specified by the socket identifier.
+ * @warn Reentrant for different SocketIds. Non reentrant for the same SocketId.
+ * @info Asynchronous
+ * @req  SWS_TCPIP_00023
+ *
+ * @param[in] id       Socket identifier of the related local socket resource.
+ * @param[in) channels Maximum number of new parallel connections established on
+ *                     this listen connection.
+ *
+ * @return E_OK:     The request has been accepted
+ *         E_NOT_OK: Maximum number of new parallel connections established on
+ *                   this listen connection.
+ */
+Std_ReturnType TcpIp_TcpListen(
+        TcpIp_SocketIdType id,
+        uint16             channels
+    )
+{
+    TcpIp_SocketType* s;
+    Std_ReturnType    res;
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPLISTEN, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    /**
+     * @req SWS_TCPIP_00113
+     * @req SWS_TCPIP_00114
+     */
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+    {
+        int v = 1;
+        /* only now, so sockets that never listen keep their address to themselves */
+        TCPIP_SYSCALL_COUNT(tcp_listen);
+        (void)setsockopt(s->fd, SOL_SOCKET, SO_REUSEPORT, &v, sizeof(v));
+    }
+#endif
+    TCPIP_SYSCALL_COUNT(tcp_listen);
+    if (listen(s->fd, channels) == 0) {
+        res = E_OK;
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+        TcpIp_ListenShards_Open(id, channels);
+#endif
+        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_LISTEN);
+    } else {
+        res = E_NOT_OK;
+    }
+    return res;
+}
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+/**
+ * @brief Queue a datagram on the ring, the buffer is released once the kernel has sent it
+ */
+static Std_ReturnType TcpIp_Uring_UdpTransmit(
+        TcpIp_SocketIdType             id,
+        const uint8*                   data,
+        const struct sockaddr_storage* addr,
+        socklen_t                      addr_len,
+        uint16                         len
+    )
+{
+    TcpIp_UringTxType* t;
+    uint16             slot;
+
+    if (len > sizeof(t->buf)) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+        return E_NOT_OK;
+    }
+
+    slot = TcpIp_Uring_TxAlloc();
+    if (slot == TCPIP_URING_TX_NONE) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_NOBUFS);
+        return E_NOT_OK;
+    }
+    t = &TcpIp_UringTx[slot];
+
+    if (data) {
+        memcpy(t->buf, data, len);
+    } else if (SoAd_CopyTxData(TCPIP_SOCKET_ID(id), t->buf, len) != BUFREQ_OK) {
+        TcpIp_Uring_TxRelease(slot);
+        return E_NOT_OK;
+    }
+
+    memcpy(&t->addr, addr, addr_len);
+    memset(&t->msg, 0, sizeof(t->msg));
+    t->len             = len;
+    t->iov.iov_base    = t->buf;
+    t->iov.iov_len     = len;
+    t->msg.msg_name    = &t->addr;
+    t->msg.msg_namelen = addr_len;
+    t->msg.msg_iov     = &t->iov;
+    t->msg.msg_iovlen  = 1u;
+
+    TcpIp_Uring_TxQueue(id, slot);
+    return E_OK;
+}
+
+/**
+ * @brief Queue stream data on the ring in TCPIP_CFG_MAX_PACKETSIZE chunks
+ *
+ * Buffers for all chunks are checked for up front, so a request is either
+ * queued completely or not at all.
+ */
+static Std_ReturnType TcpIp_Uring_TcpTransmit(
+        TcpIp_SocketIdType  id,
+        const uint8*        data,
+        uint32              available,
+        boolean             force
+    )
+{
+    TcpIp_SocketType*  s = &TcpIp_Sockets[id];
+    TcpIp_UringTxType* t;
+    uint32             chunks;
+    uint16             slot;
+
+    if ((s->fd == INVALID_SOCKET) || TcpIp_UringSockets[id].tx_shutdown) {
+        return E_NOT_OK;
+    }
+
+    /* the buffer of the caller holds all of it, only data pulled from upper layer stops early */
+    if (force || (data != NULL)) {
+        chunks = (available + sizeof(t->buf) - 1u) / sizeof(t->buf);
+    } else {
+        chunks = 1u;
+    }
+
+    if (chunks > TcpIp_UringTxFreeCount) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPTRANSMIT, TCPIP_E_NOBUFS);
+        return E_NOT_OK;
+    }
+
+    do {
+        BufReq_ReturnType r;
+        uint16            len;
+
+        slot = TcpIp_Uring_TxAlloc();
+        t    = &TcpIp_UringTx[slot];
+
+        /* deduce how much we copy each time */
+        if (available < sizeof(t->buf)) {
+            len = (uint16)available;
+        } else {
+            len = sizeof(t->buf);
+        }
+        available -= len;
+
+        if (data == NULL) {
+            r = SoAd_CopyTxData(TCPIP_SOCKET_ID(id), t->buf, len);
+            if (r != BUFREQ_OK) {
+                TcpIp_Uring_TxRelease(slot);
+                return (r == BUFREQ_E_BUSY) ? E_OK : E_NOT_OK;
+            }
+        } else {
+            memcpy(t->buf, data, len);
+            data += len;
+        }
+
+        if (len > 0u) {
+            t->len = len;
+            TcpIp_Uring_TxQueue(id, slot);
+        } else {
+            TcpIp_Uring_TxRelease(slot);
+        }
+
+    } while (available > 0u && (force || (data != NULL)));
+
+    return E_OK;
+}
+#endif
+
+/**
+ * @brief This service transmits data via UDP to a remote node. The transmission of the
+ *        data is immediately performed with this function call by forwarding it to EthIf.
+ * @warn  Reentrant for different SocketIds. Non reentrant for the same SocketId.
+ * @info  Synchronous
+ *
+ * @param[in] id     Socket identifier of the related local socket resource.
+ * @param[in] data   Pointer to a linear buffer of TotalLength bytes containing the
+ *                   data to be transmitted.
+ *                   In case DataPtr is a NULL_PTR, TcpIp shall retrieve data from
+ *                   upper layer via callback <Up>_CopyTxData().
+ * @param[in] remote IP address and port of the remote host to transmit to.
+ * @param[in] len    indicates the payload size of the UDP datagram.
+ */
+Std_ReturnType TcpIp_UdpTransmit(
+        TcpIp_SocketIdType        id,
+        const uint8*              data,
+        const TcpIp_SockAddrType* remote,
+        uint16                    len
+    )
+{
+    TcpIp_SocketType* s;
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+    int    v;
+    uint8* buf = NULL;
+    uint8  cls = 0u;
+    Std_ReturnType res;
+#endif
+    struct sockaddr_storage  addr;
+    socklen_t                addr_len;
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    if (remote->domain != s->domain) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_PROTOCOL);
+        return E_NOT_OK;
+    }
+
+    if (TcpIp_GetBsdSockaddrFromSocketAddr(&addr, &addr_len, remote) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    return TcpIp_Uring_UdpTransmit(id, data, &addr, addr_len, len);
+#else
+    if (data == NULL) {
+        if (len > TcpIp_PacketSize) {
+            return E_NOT_OK;
+        }
+        buf = TcpIp_TxPool_Get(len, &cls);
+        if (buf == NULL) {
+            return E_NOT_OK;
+        }
+        if (SoAd_CopyTxData(TCPIP_SOCKET_ID(id), buf, len) != BUFREQ_OK) {
+            TcpIp_TxPool_Put(buf, cls);
+            return E_NOT_OK;
+        }
+        data = buf;
+    }
+
+    for (;;) {
+        TCPIP_SYSCALL_COUNT(udp_transmit);
+        v = sendto(s->fd, data, len, 0, (struct sockaddr *)&addr, addr_len);
+        if ((v != -1) || (errno != EAGAIN)) {
+            break;
+        }
+        TCPIP_SYSCALL_COUNT(udp_transmit);
+        if (TcpIp_WaitWritable(s->fd) != E_OK) {
+            break;
+        }
+    }
+
+    if (v == -1) {
+        if (errno == EMSGSIZE) {
+            TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+        }
+        res = E_NOT_OK;
+    } else if (v != len) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+        res = E_NOT_OK;
+    } else {
+        res = E_OK;
+    }
+
+    if (buf != NULL) {
+        TcpIp_TxPool_Put(buf, cls);
+    }
+    return res;
+#endif
+}
+
+#if(TCPIP_CFG_ENABLE_SENDMMSG == STD_ON)
+/**
+ * @brief Transmit a number of UDP datagrams, TCPIP_CFG_TX_BATCH per system call
+ * @info  Synchronous
+ *
+ * A datagram that can't be sent only fails its own entry, the rest of the
+ * batch is still transmitted.
+ *
+ * @param[in]     id      Socket identifier of the related local socket resource.
+ * @param[in,out] entries Datagrams to transmit, result of each is filled in.
+ * @param[in]     count   Number of entries.
+ * @return E_OK:     All datagrams were transmitted
+ *         E_NOT_OK: At least one datagram failed, see the result of each entry
+ */
+Std_ReturnType TcpIp_UdpTransmitBatch(
+        TcpIp_SocketIdType        id,
+        TcpIp_UdpTxEntryType*     entries,
+        uint16                    count
+    )
+{
+    TcpIp_SocketType*       s;
+    TcpIp_UdpTxEntryType*   e;
+    struct mmsghdr          msg[TCPIP_CFG_TX_BATCH];
+    struct iovec            iov[TCPIP_CFG_TX_BATCH];
+    struct sockaddr_storage addr[TCPIP_CFG_TX_BATCH];
+    uint16                  slot[TCPIP_CFG_TX_BATCH];
+    socklen_t               addr_len;
+    Std_ReturnType          res = E_OK;
+    uint16                  pos = 0u, n, sent;
+    int                     v;
+
+    TCPIP_DET_CHECK_RET(entries != NULL_PTR, TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    while (pos < count) {
+        /* gather the next run of valid entries */
+        for (n = 0u; (pos < count) && (n < TCPIP_CFG_TX_BATCH); ++pos) {
+            e = &entries[pos];
+            if ((e->data == NULL_PTR) || (e->remote == NULL_PTR)) {
+                TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+                e->result = E_NOT_OK;
+                res       = E_NOT_OK;
+                continue;
+            }
+            if (e->remote->domain != s->domain) {
+                TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_PROTOCOL);
+                e->result = E_NOT_OK;
+                res       = E_NOT_OK;
+                continue;
+            }
+            if (TcpIp_GetBsdSockaddrFromSocketAddr(&addr[n], &addr_len, e->remote) != E_OK) {
+                TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+                e->result = E_NOT_OK;
+                res       = E_NOT_OK;
+                continue;
+            }
+            iov[n].iov_base                = (void*)e->data;
+            iov[n].iov_len                 = e->len;
+            memset(&msg[n], 0, sizeof(msg[n]));
+            msg[n].msg_hdr.msg_name        = &addr[n];
+            msg[n].msg_hdr.msg_namelen     = addr_len;
+            msg[n].msg_hdr.msg_iov         = &iov[n];
+            msg[n].msg_hdr.msg_iovlen      = 1u;
+            slot[n]                        = pos;
+            n++;
+        }
+
+        sent = 0u;
+        while (sent < n) {
+            TCPIP_SYSCALL_COUNT(udp_transmit);
+            v = sendmmsg(s->fd, &msg[sent], n - sent, 0);
+            if (v > 0) {
+                for (; v > 0; --v, ++sent) {
+                    e = &entries[slot[sent]];
+                    if (msg[sent].msg_len == e->len) {
+                        e->result = E_OK;
+                    } else {
+                        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+                        e->result = E_NOT_OK;
+                        res       = E_NOT_OK;
+                    }
+                }
+            } else if (errno == EINTR) {
+                continue;
+            } else if ((errno == EAGAIN) && (TcpIp_WaitWritable(s->fd) == E_OK)) {
+                TCPIP_SYSCALL_COUNT(udp_transmit);
+                continue;
+            } else {
+                /* the first datagram was refused, skip it and carry on with the rest */
+                if (errno == EMSGSIZE) {
+                    TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+                }
+                entries[slot[sent]].result = E_NOT_OK;
+                res = E_NOT_OK;
+                sent++;
+            }
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Transmit one UDP payload to a number of remotes, TCPIP_CFG_TX_BATCH per system call
+ * @info  Synchronous
+ *
+ * @param[in]  id      Socket identifier of the related local socket resource.
+ * @param[in]  data    Payload sent to every remote.
+ * @param[in]  len     Payload length in bytes.
+ * @param[in]  remotes Addresses to send the payload to.
+ * @param[out] results Outcome for each remote, may be NULL_PTR.
+ * @param[in]  count   Number of remotes.
+ * @return E_OK:     The payload was transmitted to all remotes
+ *         E_NOT_OK: At least one remote failed
+ */
+Std_ReturnType TcpIp_UdpTransmitFanout(
+        TcpIp_SocketIdType          id,
+        const uint8*                data,
+        uint16                      len,
+        const TcpIp_SockAddrType**  remotes,
+        Std_ReturnType*             results,
+        uint16                      count
+    )
+{
+    TcpIp_UdpTxEntryType entries[TCPIP_CFG_TX_BATCH];
+    Std_ReturnType       res = E_OK;
+    uint16               pos, n, i;
+
+    TCPIP_DET_CHECK_RET(remotes != NULL_PTR, TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+
+    for (pos = 0u; pos < count; pos += n) {
+        n = count - pos;
+        if (n > TCPIP_CFG_TX_BATCH) {
+            n = TCPIP_CFG_TX_BATCH;
+        }
+        for (i = 0u; i < n; ++i) {
+            entries[i].data   = data;
+            entries[i].remote = remotes[pos + i];
+            entries[i].len    = len;
+            entries[i].result = E_NOT_OK;
+        }
+        if (TcpIp_UdpTransmitBatch(id, entries, n) != E_OK) {
+            res = E_NOT_OK;
+        }
+        if (results != NULL_PTR) {
+            for (i = 0u; i < n; ++i) {
+                results[pos + i] = entries[i].result;
+            }
+        }
+    }
+    return res;
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_UDP_GSO == STD_ON)
+/**
+ * @brief Transmit a large UDP payload as datagrams of segment bytes each
+ * @info  Synchronous
+ *
+ * The kernel splits up to TCPIP_UDP_GSO_SEGMENTS segments per send. Should it
+ * refuse, the socket sends one segment per call from then on. The last
+ * datagram holds what remains and may be shorter than segment.
+ *
+ * @param[in] id      Socket identifier of the related local socket resource.
+ * @param[in] data    Payload to transmit.
+ * @param[in] remote  IP address and port of the remote host to transmit to.
+ * @param[in] len     Payload length in bytes.
+ * @param[in] segment Payload length of each datagram.
+ */
+Std_ReturnType TcpIp_UdpTransmitSegmented(
+        TcpIp_SocketIdType        id,
+        const uint8*              data,
+        const TcpIp_SockAddrType* remote,
+        uint32                    len,
+        uint16                    segment
+    )
+{
+    TcpIp_SocketType*       s;
+    struct sockaddr_storage addr;
+    socklen_t               addr_len;
+    struct msghdr           msg;
+    struct iovec            iov;
+    struct cmsghdr*         cmsg;
+    union {
+        uint8               buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr      align;
+    } control;
+    uint32                  chunk, max;
+    int                     v;
+
+    TCPIP_DET_CHECK_RET(data   != NULL_PTR, TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    TCPIP_DET_CHECK_RET(remote != NULL_PTR, TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    TCPIP_DET_CHECK_RET(segment > 0u      , TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    if (remote->domain != s->domain) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_PROTOCOL);
+        return E_NOT_OK;
+    }
+
+    if (TcpIp_GetBsdSockaddrFromSocketAddr(&addr, &addr_len, remote) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+
+    max = (TCPIP_UDP_GSO_SIZE / segment) * segment;
+    if (max > TCPIP_UDP_GSO_SEGMENTS * segment) {
+        max = TCPIP_UDP_GSO_SEGMENTS * segment;
+    }
+
+    while (len > 0u) {
+        chunk = s->udp_gso_off ? segment : max;
+        if (chunk == 0u) {
+            /* segment alone is larger than a datagram */
+            chunk = segment;
+        }
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        memset(&msg, 0, sizeof(msg));
+        iov.iov_base    = (void*)data;
+        iov.iov_len     = chunk;
+        msg.msg_name    = &addr;
+        msg.msg_namelen = addr_len;
+        msg.msg_iov     = &iov;
+        msg.msg_iovlen  = 1u;
+        if (chunk > segment) {
+            msg.msg_control    = control.buf;
+            msg.msg_controllen = sizeof(control.buf);
+            cmsg               = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level   = SOL_UDP;
+            cmsg->cmsg_type    = UDP_SEGMENT;
+            cmsg->cmsg_len     = CMSG_LEN(sizeof(uint16_t));
+            *(uint16_t*)CMSG_DATA(cmsg) = segment;
+        }
+
+        TCPIP_SYSCALL_COUNT(udp_transmit);
+        v = sendmsg(s->fd, &msg, 0);
+        if (v == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if ((errno == EAGAIN) && (TcpIp_WaitWritable(s->fd) == E_OK)) {
+                TCPIP_SYSCALL_COUNT(udp_transmit);
+                continue;
+            } else if ((chunk > segment) && ((errno == EIO) || (errno == EINVAL) || (errno == ENOPROTOOPT) || (errno == EOPNOTSUPP))) {
+                /* no segmentation offload for this socket, split in software */
+                s->udp_gso_off = TRUE;
+                continue;
+            }
+            if (errno == EMSGSIZE) {
+                TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+            }
+            return E_NOT_OK;
+        }
+
+        data += chunk;
+        len  -= chunk;
+    }
+    return E_OK;
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+/**
+ * @brief Confirm transmitted bytes to upper layer, in pieces fitting the callback
+ */
+static void TcpIp_Zerocopy_Confirm(TcpIp_SocketIdType index, uint32 len)
+{
+    uint32 chunk;
+
+    while (len > 0u) {
+        chunk = (len > 0xffffu) ? 0xffffu : len;
+        SoAd_TxConfirmation(TCPIP_SOCKET_ID(index), (uint16)chunk);
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Send straight from the buffer of upper layer, completions are confirmed by TcpIp_Zerocopy_Reap
+ *
+ * Bytes that had to be copied after all are confirmed before returning.
+ */
+static Std_ReturnType TcpIp_Zerocopy_Transmit(TcpIp_SocketIdType index, const uint8* data, uint32 len)
+{
+    TcpIp_SocketType*   s = &TcpIp_Sockets[index];
+    TcpIp_ZerocopyType* z = &TcpIp_Zerocopy[index];
+    uint32              slot;
+    boolean             early;
+    int                 flags, v;
+
+    if (!z->tried) {
+        v = 1;
+        z->tried   = TRUE;
+        TCPIP_SYSCALL_COUNT(tcp_transmit);
+        z->enabled = (setsockopt(s->fd, SOL_SOCKET, SO_ZEROCOPY, &v, sizeof(v)) == 0);
+    }
+
+    while (len > 0u) {
+        TCPIP_SOCKET_LOCK();
+        slot  = z->next & (TCPIP_CFG_ZEROCOPY_PENDING - 1u);
+        flags = (z->enabled && (z->len[slot] == 0u)) ? MSG_ZEROCOPY : 0;
+        TCPIP_SOCKET_UNLOCK();
+
+        TCPIP_SYSCALL_COUNT(tcp_transmit);
+        v = send(s->fd, data, len, flags);
+        if (v == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if ((errno == EAGAIN) && (TcpIp_WaitWritable(s->fd) == E_OK)) {
+                TCPIP_SYSCALL_COUNT(tcp_transmit);
+                continue;
+            } else if ((errno == ENOBUFS) && (flags != 0)) {
+                /* out of memory to pin pages, copy instead */
+                z->enabled = FALSE;
+                continue;
+            }
+            return E_NOT_OK;
+        }
+
+        if (flags == 0) {
+            TcpIp_Zerocopy_Confirm(index, (uint32)v);
+        } else {
+            TCPIP_SOCKET_LOCK();
+            early    = z->early;
+            z->early = FALSE;
+            if (!early) {
+                z->len[slot] = (uint32)v;
+            }
+            z->next++;
+            TCPIP_SOCKET_UNLOCK();
+            if (early) {
+                TcpIp_Zerocopy_Confirm(index, (uint32)v);
+            }
+        }
+        data += v;
+        len  -= (uint32)v;
+    }
+    return E_OK;
+}
+
+/**
+ * @brief Confirm zerocopy sends completed by the kernel, they are queued as socket errors
+ * @return TRUE when the socket holds no other error
+ */
+static boolean TcpIp_Zerocopy_Reap(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType*        s = &TcpIp_Sockets[index];
+    TcpIp_ZerocopyType*      z = &TcpIp_Zerocopy[index];
+    uint8                    control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+    struct msghdr            msg;
+    struct cmsghdr*          cmsg;
+    struct sock_extended_err serr;
+    uint32                   id, total = 0u;
+    int                      err = 0;
+    socklen_t                len = sizeof(err);
+
+    for (;;) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+        TCPIP_SYSCALL_COUNT(main_function);
+        if (recvmsg(s->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            break;
+        }
+
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!((cmsg->cmsg_level == SOL_IP)   && (cmsg->cmsg_type == IP_RECVERR))
+             && !((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+            if ((serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY) || (serr.ee_errno != 0u)) {
+                continue;
+            }
+
+            TCPIP_SOCKET_LOCK();
+            for (id = serr.ee_info; ; ++id) {
+                if (id == z->next) {
+                    /* send has not returned yet, it confirms itself */
+                    z->early = TRUE;
+                } else {
+                    total += z->len[id & (TCPIP_CFG_ZEROCOPY_PENDING - 1u)];
+                    z->len[id & (TCPIP_CFG_ZEROCOPY_PENDING - 1u)] = 0u;
+                }
+                if (id == serr.ee_data) {
+                    break;
+                }
+            }
+            TCPIP_SOCKET_UNLOCK();
+        }
+    }
+    TcpIp_Zerocopy_Confirm(index, total);
+
+    TCPIP_SYSCALL_COUNT(main_function);
+    if (getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0) {
+        return FALSE;
+    }
+    return (err == 0);
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_VECTOR == STD_ON)
+/**
+ * @brief Write all segments to the socket, continuing after partial writes
+ * @param[in,out] iov   Segments to write, consumed while writing
+ * @param[in]     count Number of segments
+ */
+static Std_ReturnType TcpIp_TcpTx_SendVector(TcpIp_SocketIdType index, struct iovec* iov, uint16 count, int flags)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    struct msghdr     msg;
+    ssize_t           v;
+
+    memset(&msg, 0, sizeof(msg));
+    while (count > 0u) {
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = count;
+        TCPIP_SYSCALL_COUNT(tcp_transmit);
+        v = sendmsg(s->fd, &msg, flags);
+        if (v == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if ((errno == EAGAIN) && (TcpIp_WaitWritable(s->fd) == E_OK)) {
+                TCPIP_SYSCALL_COUNT(tcp_transmit);
+                continue;
+            }
+            return E_NOT_OK;
+        }
+
+        /* drop what was written, the kernel may stop in the middle of a segment */
+        while ((count > 0u) && ((size_t)v >= iov->iov_len)) {
+            v -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0u) {
+            iov->iov_base = (uint8*)iov->iov_base + v;
+            iov->iov_len -= (size_t)v;
+        }
+    }
+    return E_OK;
+}
+
+/**
+ * @brief Transmit data held in a list of separate buffers, as one stream
+ * @info  Synchronous
+ *
+ * Segments are written with one sendmsg call per TCPIP_CFG_TX_SEGMENTS,
+ * the buffers may be reused once the call returns.
+ *
+ * @param[in] id       Socket identifier of the related local socket resource.
+ * @param[in] segments Buffers to transmit, in order.
+ * @param[in] count    Number of segments.
+ */
+Std_ReturnType TcpIp_TcpTransmitVector(
+        TcpIp_SocketIdType          id,
+        const TcpIp_TxSegmentType*  segments,
+        uint16                      count
+    )
+{
+    struct iovec iov[TCPIP_CFG_TX_SEGMENTS];
+    uint16       pos, n, i;
+
+    TCPIP_DET_CHECK_RET(segments != NULL_PTR, TCPIP_API_TCPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+
+    for (pos = 0u; pos < count; pos += n) {
+        n = count - pos;
+        if (n > TCPIP_CFG_TX_SEGMENTS) {
+            n = TCPIP_CFG_TX_SEGMENTS;
+        }
+        for (i = 0u; i < n; ++i) {
+            iov[i].iov_base = (void*)segments[pos + i].data;
+            iov[i].iov_len  = segments[pos + i].len;
+        }
+        if (TcpIp_TcpTx_SendVector(id, iov, n, 0) != E_OK) {
+            return E_NOT_OK;
+        }
+    }
+    return E_OK;
+}
+
+/**
+ * @brief Transmit available bytes of upper layer, sent straight from the segments it points out
+ *
+ * SoAd_GetTxSegments describes the bytes in at most count segments, which
+ * must stay valid until the transmit returns.
+ */
+static Std_ReturnType TcpIp_TcpTx_Segments(TcpIp_SocketIdType index, uint32 available, int flags)
+{
+    TcpIp_TxSegmentType segments[TCPIP_CFG_TX_SEGMENTS];
+    struct iovec        iov[TCPIP_CFG_TX_SEGMENTS];
+    uint16              count = TCPIP_CFG_TX_SEGMENTS;
+    uint16              i;
+    BufReq_ReturnType   r;
+
+    r = SoAd_GetTxSegments(TCPIP_SOCKET_ID(index), segments, &count, available);
+    if (r == BUFREQ_E_BUSY) {
+        return E_OK;
+    } else if ((r != BUFREQ_OK) || (count > TCPIP_CFG_TX_SEGMENTS)) {
+        return E_NOT_OK;
+    }
+
+    for (i = 0u; i < count; ++i) {
+        iov[i].iov_base = (void*)segments[i].data;
+        iov[i].iov_len  = segments[i].len;
+    }
+    return TcpIp_TcpTx_SendVector(index, iov, count, flags);
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF) && (TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_OFF)
+/**
+ * @brief Hand all of data to the kernel, waiting for room as needed
+ * @param[out] taken Bytes the first send took before any wait, may be NULL
+ */
+static Std_ReturnType TcpIp_TcpTx_SendAll(TcpIp_SocketIdType index, const uint8* data, uint32 len, int flags, uint32* taken)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    boolean           first = TRUE;
+    int               v;
+
+    while (len > 0u) {
+        TCPIP_SYSCALL_COUNT(tcp_transmit);
+        v = send(s->fd, data, len, flags);
+        if (v == -1) {
+            v = errno;
+            if (v == EINTR) {
+                continue;
+            } else if ((v == EAGAIN) && (TcpIp_WaitWritable(s->fd) == E_OK)) {
+                TCPIP_SYSCALL_COUNT(tcp_transmit);
+                v = 0;
+            } else {
+                return E_NOT_OK;
+            }
+        }
+        if (first && (taken != NULL)) {
+            *taken = (uint32)v;
+        }
+        first = FALSE;
+        len  -= (uint32)v;
+        data += v;
+    }
+    return E_OK;
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+/**
+ * @brief Hold back partial segments of the socket until it is uncorked
+ */
+static void TcpIp_TcpTx_Cork(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    int               v = 1;
+
+    if (__atomic_load_n(&s->tx_corked, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    TCPIP_SYSCALL_COUNT(tcp_transmit);
+    (void)setsockopt(s->fd, IPPROTO_TCP, TCP_CORK, &v, sizeof(v));
+    /* published after the cork, so whoever uncorks does so after it */
+    __atomic_store_n(&s->tx_corked, TRUE, __ATOMIC_SEQ_CST);
+
+    /* a socket uncorked by a forced transmit may still be listed */
+    if (__atomic_exchange_n(&s->tx_cork_listed, TRUE, __ATOMIC_SEQ_CST)) {
+        return;
+    }
+    s->tx_cork_next = __atomic_load_n(&TcpIp_TxCorked, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&TcpIp_TxCorked, &s->tx_cork_next, index, TRUE, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        /* retry on the updated head */
+    }
+    TCPIP_NOTIFY();
+}
+
+/**
+ * @brief Push out what the cork of the socket held back
+ */
+static void TcpIp_TcpTx_Uncork(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    int               v = 0;
+
+    if (!__atomic_exchange_n(&s->tx_corked, FALSE, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    TCPIP_SYSCALL_COUNT(tcp_transmit);
+    (void)setsockopt(s->fd, IPPROTO_TCP, TCP_CORK, &v, sizeof(v));
+}
+
+/**
+ * @brief Uncork every socket corked since the last call, bounds how long data is held back
+ */
+static void TcpIp_TcpTx_UncorkAll(void)
+{
+    TcpIp_SocketIdType index = __atomic_exchange_n(&TcpIp_TxCorked, TCPIP_SOCKETID_INVALID, __ATOMIC_ACQUIRE);
+    TcpIp_SocketIdType next;
+
+    while (index != TCPIP_SOCKETID_INVALID) {
+        next = TcpIp_Sockets[index].tx_cork_next;
+        /* corking again from here on lists the socket anew */
+        __atomic_store_n(&TcpIp_Sockets[index].tx_cork_listed, FALSE, __ATOMIC_SEQ_CST);
+        if (TcpIp_Sockets[index].fd != INVALID_SOCKET) {
+            TcpIp_TcpTx_Uncork(index);
+        }
+        index = next;
+    }
+}
+
+/**
+ * @brief Finish a transmit, a forced one pushes out all held back data
+ */
+static Std_ReturnType TcpIp_TcpTx_Done(TcpIp_SocketIdType index, boolean force, Std_ReturnType res)
+{
+    if (force) {
+        TcpIp_TcpTx_Uncork(index);
+    }
+    return res;
+}
+
+/**
+ * @brief Pull available bytes from upper layer in chunks sized to what the kernel takes
+ *
+ * All but the last chunk of a forced transmit are sent with MSG_MORE, so the
+ * kernel only pushes full segments until the stream is complete.
+ */
+static Std_ReturnType TcpIp_TcpTx_Coalesce(TcpIp_SocketIdType index, uint32 available, boolean force)
+{
+    TcpIp_SocketType* s   = &TcpIp_Sockets[index];
+    uint8*            buf = &TcpIp_TcpCoalesceData[(uint32)index * TCPIP_CFG_TCP_COALESCE_SIZE];
+    uint32            len, taken, min;
+    BufReq_ReturnType r;
+
+    min = (TcpIp_PacketSize < TCPIP_CFG_TCP_COALESCE_SIZE) ? TcpIp_PacketSize : TCPIP_CFG_TCP_COALESCE_SIZE;
+
+    do {
+        len = (available < s->tx_chunk) ? available : s->tx_chunk;
+        r = SoAd_CopyTxData(TCPIP_SOCKET_ID(index), buf, (uint16)len);
+        if (r == BUFREQ_E_BUSY) {
+            break;
+        } else if (r != BUFREQ_OK) {
+            return E_NOT_OK;
+        }
+        available -= len;
+
+        taken = len;
+        if (TcpIp_TcpTx_SendAll(index, buf, len, (force && (available > 0u)) ? MSG_MORE : 0, &taken) != E_OK) {
+            return E_NOT_OK;
+        }
+
+        if (taken < len) {
+            s->tx_chunk = (taken > min) ? taken : min;
+        } else if ((len == s->tx_chunk) && (s->tx_chunk < TCPIP_CFG_TCP_COALESCE_SIZE)) {
+            s->tx_chunk = (s->tx_chunk * 2u < TCPIP_CFG_TCP_COALESCE_SIZE) ? s->tx_chunk * 2u : TCPIP_CFG_TCP_COALESCE_SIZE;
+        }
+    } while ((available > 0u) && force);
+    return E_OK;
+}
+#endif
+
+Std_ReturnType TcpIp_TcpTransmit(
+        TcpIp_SocketIdType  id,
+        const uint8*        data,
+        uint32              available,
+        boolean             force
+    )
+{
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF) && (TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_OFF) && (TCPIP_CFG_ENABLE_TCP_COALESCE == STD_OFF)
+    Std_ReturnType    res = E_OK;
+    uint8*            buf = NULL;
+    uint8             cls = 0u;
+#endif
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    return TcpIp_Uring_TcpTransmit(id, data, available, force);
+#elif(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+    return TcpIp_TcpTx_Transmit(id, data, available, force);
+#else
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    if (!force) {
+        TcpIp_TcpTx_Cork(id);
+    } else if (available == 0u) {
+        /* nothing new, push out what earlier transmits held back */
+        TcpIp_TcpTx_Uncork(id);
+        return E_OK;
+    }
+#endif
+
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+    if ((data != NULL) && (available >= TCPIP_CFG_ZEROCOPY_MIN_SIZE)) {
+        return TCPIP_TCP_TX_DONE(id, force, TcpIp_Zerocopy_Transmit(id, data, available));
+    }
+#endif
+
+#if(TCPIP_CFG_ENABLE_TCP_TX_VECTOR == STD_ON)
+    if (data == NULL) {
+        return TCPIP_TCP_TX_DONE(id, force, TcpIp_TcpTx_Segments(id, available, 0));
+    }
+#endif
+
+    if (data != NULL) {
+        /* the buffer of the caller holds all of it, no need to go by chunks */
+        return TCPIP_TCP_TX_DONE(id, force, TcpIp_TcpTx_SendAll(id, data, available, 0, NULL));
+    }
+
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    return TcpIp_TcpTx_Done(id, force, TcpIp_TcpTx_Coalesce(id, available, force));
+#else
+    do {
+        BufReq_ReturnType r;
+        uint16            len;
+
+        /* deduce how much we copy each time */
+        if (available < TcpIp_PacketSize) {
+            len = (uint16)available;
+        } else {
+            len = TcpIp_PacketSize;
+        }
+        available -= len;
+
+        /* chunks only shrink, so the first buffer borrowed fits all of them */
+        if (buf == NULL) {
+            buf = TcpIp_TxPool_Get(len, &cls);
+            if (buf == NULL) {
+                res = E_NOT_OK;
+                break;
+            }
+        }
+        r = SoAd_CopyTxData(TCPIP_SOCKET_ID(id), buf, len);
+        if (r == BUFREQ_E_BUSY) {
+            break;
+        } else if (r != BUFREQ_OK) {
+            res = E_NOT_OK;
+            break;
+        }
+
+        /* we must enqueue all data we copied */
+        res = TcpIp_TcpTx_SendAll(id, buf, len, 0, NULL);
+    } while ((res == E_OK) && (available > 0u) && force);
+
+    if (buf != NULL) {
+        TcpIp_TxPool_Put(buf, cls);
+    }
+    return res;
+#endif
+#endif
+}
+
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+/**
+ * @brief Payload of a queue entry, TcpIp_PacketSize bytes
+ */
+static uint8* TcpIp_TxQueue_Buf(const TcpIp_TxQueueEntryType* e)
+{
+    return &TcpIp_TxQueueData[(uint32)(e - TcpIp_TxQueue) * TcpIp_PacketSize];
+}
+
+static uint64 TcpIp_TxQueue_Now(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64)ts.tv_sec * 1000000u + (uint64)ts.tv_nsec / 1000u;
+}
+
+static void TcpIp_TxQueue_Init(void)
+{
+    uint32 pos;
+    for (pos = 0u; pos < TCPIP_CFG_TX_QUEUE_ENTRIES; ++pos) {
+        __atomic_store_n(&TcpIp_TxQueue[pos].seq, pos, __ATOMIC_RELAXED);
+    }
+    TcpIp_TxQueueHead = 0u;
+    __atomic_store_n(&TcpIp_TxQueueTail, 0u, __ATOMIC_RELAXED);
+    memset(&TcpIp_TxQueueStats, 0, sizeof(TcpIp_TxQueueStats));
+}
+
+/**
+ * @brief Claim a free entry, never blocks
+ * @return Entry to fill or NULL if the queue is full
+ */
+static TcpIp_TxQueueEntryType* TcpIp_TxQueue_Claim(void)
+{
+    TcpIp_TxQueueEntryType* e;
+    uint32                  pos;
+    sint32                  diff;
+
+    pos = __atomic_load_n(&TcpIp_TxQueueTail, __ATOMIC_RELAXED);
+    for (;;) {
+        e    = &TcpIp_TxQueue[pos & (TCPIP_CFG_TX_QUEUE_ENTRIES - 1u)];
+        diff = (sint32)(__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&TcpIp_TxQueueTail, &pos, pos + 1u, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            (void)__atomic_fetch_add(&TcpIp_TxQueueStats.rejected, 1u, __ATOMIC_RELAXED);
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&TcpIp_TxQueueTail, __ATOMIC_RELAXED);
+        }
+    }
+
+    e->stamp = TcpIp_TxQueue_Now();
+    return e;
+}
+
+/**
+ * @brief Hand a filled entry to the consumer
+ */
+static void TcpIp_TxQueue_Publish(TcpIp_TxQueueEntryType* e)
+{
+    uint32 pos = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+    uint32 depth;
+
+    uint32 depth_max;
+
+    depth     = __atomic_add_fetch(&TcpIp_TxQueueStats.depth, 1u, __ATOMIC_RELAXED);
+    depth_max = __atomic_load_n(&TcpIp_TxQueueStats.depth_max, __ATOMIC_RELAXED);
+    while ((depth > depth_max)
+       &&  !__atomic_compare_exchange_n(&TcpIp_TxQueueStats.depth_max, &depth_max, depth, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        /* retry with the updated maximum */
+    }
+    (void)__atomic_fetch_add(&TcpIp_TxQueueStats.enqueued, 1u, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&e->seq, pos + 1u, __ATOMIC_RELEASE);
+    TCPIP_NOTIFY();
+}
+
+/**
+ * @brief Transmit everything queued so far, called by the main function only
+ */
+static void TcpIp_TxQueue_Drain(void)
+{
+    TcpIp_TxQueueEntryType* e;
+    Std_ReturnType          res;
+    uint32                  pos;
+    uint64                  latency;
+    uint64                  now = 0u;
+
+    for (;;) {
+        pos = TcpIp_TxQueueHead;
+        e   = &TcpIp_TxQueue[pos & (TCPIP_CFG_TX_QUEUE_ENTRIES - 1u)];
+        if (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != pos + 1u) {
+            break;
+        }
+
+        if (now == 0u) {
+            now = TcpIp_TxQueue_Now();
+        }
+        /* only the consumer writes these, atomics keep readers consistent */
+        latency = (now > e->stamp) ? (now - e->stamp) : 0u;
+        (void)__atomic_fetch_add(&TcpIp_TxQueueStats.latency_total, latency, __ATOMIC_RELAXED);
+        if (latency > TcpIp_TxQueueStats.latency_max) {
+            __atomic_store_n(&TcpIp_TxQueueStats.latency_max, latency, __ATOMIC_RELAXED);
+        }
+
+        if (e->protocol == TCPIP_IPPROTO_UDP) {
+            res = TcpIp_UdpTransmit(e->id, TcpIp_TxQueue_Buf(e), &e->remote.base, e->len);
+        } else {
+            res = TcpIp_TcpTransmit(e->id, TcpIp_TxQueue_Buf(e), e->len, TRUE);
+        }
+        if (res != E_OK) {
+            (void)__atomic_fetch_add(&TcpIp_TxQueueStats.failed, 1u, __ATOMIC_RELAXED);
+        }
+
+        (void)__atomic_sub_fetch(&TcpIp_TxQueueStats.depth, 1u, __ATOMIC_RELAXED);
+        TcpIp_TxQueueHead = pos + 1u;
+        __atomic_store_n(&e->seq, pos + TCPIP_CFG_TX_QUEUE_ENTRIES, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Queue a UDP datagram for transmission by the next main function.
+ * @info  Reentrant, never blocks
+ *
+ * @param[in] id     Socket identifier of the related local socket resource.
+ * @param[in] data   Payload, copied before the function returns.
+ * @param[in] remote IP address and port of the remote host to transmit to.
+ * @param[in] len    Payload size, at most the packet size selected at init.
+ * @return E_OK:     Datagram was queued
+ *         E_NOT_OK: Queue is full or arguments are invalid
+ */
+Std_ReturnType TcpIp_UdpTransmitQueued(
+        TcpIp_SocketIdType        id,
+        const uint8*              data,
+        const TcpIp_SockAddrType* remote,
+        uint16                    len
+    )
+{
+    TcpIp_TxQueueEntryType* e;
+    TcpIp_SocketIdType      index;
+
+    if (TcpIp_SocketIndex(id, &index) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    TCPIP_DET_CHECK_RET(data   != NULL, TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    TCPIP_DET_CHECK_RET(remote != NULL, TCPIP_API_UDPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    TCPIP_DET_CHECK_RET(len <= TcpIp_PacketSize, TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
+
+    e = TcpIp_TxQueue_Claim();
+    if (e == NULL) {
+        return E_NOT_OK;
+    }
+
+    e->id       = id;
+    e->protocol = TCPIP_IPPROTO_UDP;
+    e->len      = len;
+    if (remote->domain == TCPIP_AF_INET6) {
+        memcpy(&e->remote.inet6, remote, sizeof(e->remote.inet6));
+    } else {
+        memcpy(&e->remote.inet , remote, sizeof(e->remote.inet));
+    }
+    memcpy(TcpIp_TxQueue_Buf(e), data, len);
+
+    TcpIp_TxQueue_Publish(e);
+    return E_OK;
+}
+
+/**
+ * @brief Queue TCP data for transmission by the next main function.
+ * @info  Reentrant, never blocks
+ *
+ * @param[in] id     Socket identifier of the related local socket resource.
+ * @param[in] data   Payload, copied before the function returns.
+ * @param[in] len    Payload size, at most the packet size selected at init.
+ * @return E_OK:     Data was queued
+ *         E_NOT_OK: Queue is full or arguments are invalid
  */
-Std_ReturnType TcpIp_Close(
-        TcpIp_SocketIdType          id,
-        boolean                     abort
+Std_ReturnType TcpIp_TcpTransmitQueued(
+        TcpIp_SocketIdType        id,
+        const uint8*              data,
+        uint16                    len
     )
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    Std_ReturnType   res;
+    TcpIp_TxQueueEntryType* e;
+    TcpIp_SocketIdType      index;
 
-    if (s->protocol == TCPIP_IPPROTO_TCP) {
-        if (abort) {
-            TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
-            res = E_OK;
-        } else {
-            if (s->state == TCPIP_SOCKET_STATE_CONNECTED) {
-                if (shutdown(s->fd, SHUT_WR) == 0) {
-                    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_SHUTDOWN);
-                    res = E_OK;
-                } else {
-                    res = E_NOT_OK;
-                }
-            } else {
-                TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
-                res = E_OK;
-            }
+    if (TcpIp_SocketIndex(id, &index) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPTRANSMIT, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    TCPIP_DET_CHECK_RET(data != NULL, TCPIP_API_TCPTRANSMIT, TCPIP_E_PARAM_POINTER);
+    TCPIP_DET_CHECK_RET(len <= TcpIp_PacketSize, TCPIP_API_TCPTRANSMIT, TCPIP_E_MSGSIZE);
+
+    e = TcpIp_TxQueue_Claim();
+    if (e == NULL) {
+        return E_NOT_OK;
+    }
+
+    e->id       = id;
+    e->protocol = TCPIP_IPPROTO_TCP;
+    e->len      = len;
+    memcpy(TcpIp_TxQueue_Buf(e), data, len);
+
+    TcpIp_TxQueue_Publish(e);
+    return E_OK;
+}
+
+/**
+ * @brief Read the transmit queue counters
+ * @param[out] stats Snapshot of the counters
+ */
+void TcpIp_GetTxQueueStats(TcpIp_TxQueueStatsType* stats)
+{
+    stats->depth         = __atomic_load_n(&TcpIp_TxQueueStats.depth        , __ATOMIC_RELAXED);
+    stats->depth_max     = __atomic_load_n(&TcpIp_TxQueueStats.depth_max    , __ATOMIC_RELAXED);
+    stats->enqueued      = __atomic_load_n(&TcpIp_TxQueueStats.enqueued     , __ATOMIC_RELAXED);
+    stats->rejected      = __atomic_load_n(&TcpIp_TxQueueStats.rejected     , __ATOMIC_RELAXED);
+    stats->failed        = __atomic_load_n(&TcpIp_TxQueueStats.failed       , __ATOMIC_RELAXED);
+    stats->latency_max   = __atomic_load_n(&TcpIp_TxQueueStats.latency_max  , __ATOMIC_RELAXED);
+    stats->latency_total = __atomic_load_n(&TcpIp_TxQueueStats.latency_total, __ATOMIC_RELAXED);
+}
+#endif
+
+Std_ReturnType TcpIp_TcpReceived(
+        TcpIp_SocketIdType id,
+        uint32             len
+    )
+{
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_TCPRECEIVED, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+    if ((__atomic_fetch_add(&TcpIp_Sockets[id].rx_credit, len, __ATOMIC_ACQ_REL) == 0u) && (len > 0u)) {
+        /* reading may have stopped, have the main function pick the socket up again */
+        __atomic_store_n(&TcpIp_RxResume, TRUE, __ATOMIC_RELEASE);
+        TCPIP_NOTIFY();
+    }
+#endif
+    return E_OK;
+}
+
+/**
+ * @brief Claim free slots for sockets under one lock, the slots are returned on entering UNUSED
+ * @param[out] index Slots claimed
+ * @param[in]  count Number of slots wanted
+ * @return Number of slots claimed, fewer than wanted if the table runs out
+ */
+static uint32 TcpIp_AllocSockets(TcpIp_DomainType domain, TcpIp_ProtocolType protocol, TcpIp_SocketIdType* index, uint32 count)
+{
+    TcpIp_SocketType*  s;
+    TcpIp_SocketIdType i;
+    uint32             free;
+    uint32             claimed = 0u;
+
+    TCPIP_SOCKET_LOCK();
+    for (free = TcpIp_FreeCount; (free > 0u) && (claimed < count); --free) {
+        i = TcpIp_FreeSocket_Pop();
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+        if (!TcpIp_Uring_Idle(i)) {
+            /* requests of the previous owner still in flight */
+            TcpIp_FreeSocket_Push(i);
+            continue;
         }
-    } else if (s->protocol == TCPIP_IPPROTO_UDP) {
-        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
-        res = E_OK;
-    } else {
-        res = E_NOT_OK;
+#endif
+        s           = &TcpIp_Sockets[i];
+        s->state    = TCPIP_SOCKET_STATE_ALLOCATED;
+        s->protocol = protocol;
+        s->domain   = domain;
+#if(TCPIP_CFG_ENABLE_SOCKET_GENERATION == STD_ON)
+        do {
+            s->generation = (uint16)((s->generation + 1u) & (0xffffu >> TCPIP_CFG_SOCKET_INDEX_BITS));
+            s->id         = (TcpIp_SocketIdType)((s->generation << TCPIP_CFG_SOCKET_INDEX_BITS) | i);
+        } while (s->id == TCPIP_SOCKETID_INVALID);
+#endif
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+        __atomic_store_n(&s->rx_credit, TCPIP_CFG_RX_CREDIT, __ATOMIC_RELAXED);
+        s->rx_paused = FALSE;
+#endif
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+        TcpIp_RxRings[i].head = 0u;
+        TcpIp_RxRings[i].tail = 0u;
+#endif
+#if(TCPIP_CFG_ENABLE_UDP_GSO == STD_ON)
+        s->udp_gso_off = FALSE;
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+        s->tx_chunk    = TcpIp_PacketSize;
+        if (s->tx_chunk > TCPIP_CFG_TCP_COALESCE_SIZE) {
+            s->tx_chunk = TCPIP_CFG_TCP_COALESCE_SIZE;
+        }
+        s->tx_corked   = FALSE;
+#endif
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+        s->shard_owner = TCPIP_SOCKETID_INVALID;
+        s->shard_next  = TCPIP_SOCKETID_INVALID;
+        s->shard_home  = TCPIP_SHARD_NONE;
+#endif
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+        memset(&TcpIp_Zerocopy[i], 0, sizeof(TcpIp_Zerocopy[i]));
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+        __atomic_store_n(&TcpIp_TcpTx[i].head, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&TcpIp_TcpTx[i].tail, 0u, __ATOMIC_RELAXED);
+        TcpIp_TcpTx[i].shutdown = FALSE;
+#endif
+        index[claimed++] = i;
     }
+    TCPIP_SOCKET_UNLOCK();
+    return claimed;
+}
 
-    return res;
+/**
+ * @brief Claim a free slot for a socket, the slot is returned on entering UNUSED
+ * @param[out] index Slot claimed
+ */
+static Std_ReturnType TcpIp_AllocSocket(TcpIp_DomainType domain, TcpIp_ProtocolType protocol, TcpIp_SocketIdType* index)
+{
+    return (TcpIp_AllocSockets(domain, protocol, index, 1u) == 1u) ? E_OK : E_NOT_OK;
 }
 
 /**
- * @brief By this API service the TCP/IP stack is requested to bind a UDP or TCP socket to a local resource.
- * @param[in] id          Socket identifier of the related local socket resource.
- * @param[in] local_addr  IP address identifier representing the local IP address and EthIf
- *                        controller to bind the socket to.
- *                        Note: to listen to all EthIf controller, TCPIP_LOCALADDRID_ANY
- *                              has to be specified as LocalAddrId.
- *                        Note: to listen on any IP addresss of a EthIf controller, the
- *                              configuration parameter TcpIpStaticIpAddress referenced by
- *                              LocalAddrId must be set to "ANY". The remote IP address of an
- *                              incoming packet has no effect then.
- *                        In case the socket shall be used as client socket, the IP address
- *                              and EthIf controller represented by LocalAddrId is used for
- *                              transmission.
- *                        Note: for an automatic selection of the Local IP address and EthIf
- *                              Controller, TCPIP_LOCALADDRID_ANY has to be specified as
- *                              LocalAddrId
- * @param[in,out] port    Pointer to memory where the local port to which the socket shall
- *                        be bound is specified. In case the parameter is specified as
- *                        TCPIP_PORT_ANY, the TCP/IP stack shall choose the local port
- *                        automatically from the range 49152 to 65535 and shall update the
- *                        parameter to the chosen value.
+ * @brief By this API service the TCP/IP stack is requested to allocate a new socket.
+ */
+Std_ReturnType TcpIp_SoAdGetSocket(
+        TcpIp_DomainType    domain,
+        TcpIp_ProtocolType  protocol,
+        TcpIp_SocketIdType* socketid
+    )
+{
+    TcpIp_SocketIdType index;
+    TcpIp_OsSocketType fd;
+
+    /* every operation is driven by readiness, so the mode never changes after this */
+    TCPIP_SYSCALL_COUNT(get_socket);
+    fd = socket( TcpIp_GetBsdDomainFromDomain(domain)
+               , TcpIp_GetBsdTypeFromProtocol(protocol) | SOCK_NONBLOCK | SOCK_CLOEXEC
+               , 0);
+    if (fd == INVALID_SOCKET) {
+        return E_NOT_OK;
+    }
+
+#if(TCPIP_CFG_ENABLE_UDP_GRO == STD_ON)
+    if (protocol == TCPIP_IPPROTO_UDP) {
+        int v = 1;
+        /* without kernel support datagrams keep arriving one by one */
+        TCPIP_SYSCALL_COUNT(get_socket);
+        (void)setsockopt(fd, SOL_UDP, UDP_GRO, &v, sizeof(v));
+    }
+#endif
+
+    if (TcpIp_AllocSocket(domain, protocol, &index) != E_OK) {
+        TCPIP_SYSCALL_COUNT(get_socket);
+        closesocket(fd);
+        return E_NOT_OK;
+    }
+
+    TcpIp_Sockets[index].fd = fd;
+    *socketid = TCPIP_SOCKET_ID(index);
+    return E_OK;
+}
+
+/**
+ * @brief Read a parameter value of the given width in host byte order
+ */
+static int TcpIp_ParameterValue(const uint8* value, size_t size)
+{
+    uint32 v32;
+    uint16 v16;
+
+    switch (size) {
+        case sizeof(uint32):
+            memcpy(&v32, value, sizeof(v32));
+            return v32 > (uint32)INT_MAX ? INT_MAX : (int)v32;
+        case sizeof(uint16):
+            memcpy(&v16, value, sizeof(v16));
+            return (int)v16;
+        default:
+            return (int)*value;
+    }
+}
+
+/**
+ * @brief By this API service the TCP/IP stack is requested to change a parameter of a socket. E.g. the Nagle algorithm may be controlled by this API.
  *
- * @req SWS_TCPIP_00015
+ * Parameters are mapped onto the matching socket option of the kernel socket. Options
+ * set on a listening socket are copied by the kernel onto every connection accepted
+ * from it, so a value given before connect or accept applies to the connection too.
  *
+ * @req SWS_TCPIP_00016
+ * @req SWS_TCPIP_00119
  */
-Std_ReturnType TcpIp_Bind(
-        TcpIp_SocketIdType          id,
-        TcpIp_LocalAddrIdType       local_addr,
-        uint16*                     port
+Std_ReturnType TcpIp_ChangeParameter(
+        TcpIp_SocketIdType id,
+        TcpIp_ParamIdType  parm,
+        const uint8*       value
     )
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    Std_ReturnType    res;
-    union {
-        struct sockaddr_in  in;
-        struct sockaddr_in6 in6;
-    } addr = {};
-    socklen_t len;
+    TcpIp_SocketType*  s;
+    boolean            tcp   = FALSE;
+    boolean            setup = FALSE;
+    int                level;
+    int                name;
+    int                v;
 
-    if (local_addr != TCPIP_LOCALADDRID_ANY) {
-        /** @req SWS_TCPIP_00111-TODO */
-        /** @req SWS_TCPIP_00147-TODO */
-        res = E_NOT_OK;
-        goto done;
+    TCPIP_DET_CHECK_RET(value != NULL_PTR, TCPIP_API_CHANGEPARAMETER, TCPIP_E_PARAM_POINTER);
+
+    if (TcpIp_SocketIndex(id, &id) != E_OK) {
+        TCPIP_DET_ERROR(TCPIP_API_CHANGEPARAMETER, TCPIP_E_INV_ARG);
+        return E_NOT_OK;
+    }
+    s = &TcpIp_Sockets[id];
+
+    switch (parm) {
+        case TCPIP_PARAMID_TCP_RXWND_MAX:
+            /* the window scale is negotiated on connect, so the buffer must be sized before it */
+            tcp   = TRUE;
+            setup = TRUE;
+            level = SOL_SOCKET;
+            name  = SO_RCVBUF;
+            v     = TcpIp_ParameterValue(value, sizeof(uint16));
+            break;
+        case TCPIP_PARAMID_FRAMEPRIO:
+            level = SOL_SOCKET;
+            name  = SO_PRIORITY;
+            v     = TcpIp_ParameterValue(value, sizeof(uint8));
+            break;
+        case TCPIP_PARAMID_TCP_NAGLE:
+            tcp   = TRUE;
+            level = IPPROTO_TCP;
+            name  = TCP_NODELAY;
+            v     = TcpIp_ParameterValue(value, sizeof(uint8)) ? 0 : 1;
+            break;
+        case TCPIP_PARAMID_TCP_KEEPALIVE:
+            tcp   = TRUE;
+            level = SOL_SOCKET;
+            name  = SO_KEEPALIVE;
+            v     = TcpIp_ParameterValue(value, sizeof(uint8)) ? 1 : 0;
+            break;
+        case TCPIP_PARAMID_TTL:
+            if (s->domain == TCPIP_AF_INET6) {
+                level = IPPROTO_IPV6;
+                name  = IPV6_UNICAST_HOPS;
+            } else {
+                level = IPPROTO_IP;
+                name  = IP_TTL;
+            }
+            v     = TcpIp_ParameterValue(value, sizeof(uint8));
+            break;
+        case TCPIP_PARAMID_TCP_KEEPALIVE_TIME:
+            tcp   = TRUE;
+            level = IPPROTO_TCP;
+            name  = TCP_KEEPIDLE;
+            v     = TcpIp_ParameterValue(value, sizeof(uint32));
+            break;
+        case TCPIP_PARAMID_TCP_KEEPALIVE_PROBES_MAX:
+            tcp   = TRUE;
+            level = IPPROTO_TCP;
+            name  = TCP_KEEPCNT;
+            v     = TcpIp_ParameterValue(value, sizeof(uint16));
+            break;
+        case TCPIP_PARAMID_TCP_KEEPALIVE_INTERVAL:
+            tcp   = TRUE;
+            level = IPPROTO_TCP;
+            name  = TCP_KEEPINTVL;
+            v     = TcpIp_ParameterValue(value, sizeof(uint32));
+            break;
+        default:
+            TCPIP_DET_ERROR(TCPIP_API_CHANGEPARAMETER, TCPIP_E_INV_ARG);
+            return E_NOT_OK;
+    }
+
+    if (tcp && s->protocol != TCPIP_IPPROTO_TCP) {
+        TCPIP_DET_ERROR(TCPIP_API_CHANGEPARAMETER, TCPIP_E_PROTOCOL);
+        return E_NOT_OK;
+    }
+
+    switch (s->state) {
+        case TCPIP_SOCKET_STATE_ALLOCATED:
+        case TCPIP_SOCKET_STATE_BOUND:
+        case TCPIP_SOCKET_STATE_LISTEN:
+            break;
+        case TCPIP_SOCKET_STATE_CONNECTING:
+        case TCPIP_SOCKET_STATE_CONNECTED:
+            if (setup) {
+                TCPIP_DET_ERROR(TCPIP_API_CHANGEPARAMETER, TCPIP_E_ISCONN);
+                return E_NOT_OK;
+            }
+            break;
+        default:
+            TCPIP_DET_ERROR(TCPIP_API_CHANGEPARAMETER, TCPIP_E_NOTCONN);
+            return E_NOT_OK;
+    }
+
+    TCPIP_SYSCALL_COUNT(change_parameter);
+    if (setsockopt(s->fd, level, name, &v, sizeof(v)) != 0) {
+        return E_NOT_OK;
+    }
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+    for (id = s->shard_next; id != TCPIP_SOCKETID_INVALID; id = TcpIp_Sockets[id].shard_next) {
+        TCPIP_SYSCALL_COUNT(change_parameter);
+        (void)setsockopt(TcpIp_Sockets[id].fd, level, name, &v, sizeof(v));
+    }
+#endif
+    return E_OK;
+}
+
+void TcpIp_SocketState_Connecting(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    struct pollfd*    p = &TcpIp_PollFds[index];
+    int v;
+
+    if ((p->revents & POLLHUP) || (p->revents & POLLERR)) {
+        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+        return;
+    }
+
+    if (p->revents & POLLOUT) {
+        struct sockaddr_storage addr;
+        socklen_t len = sizeof(addr);
+
+        /* check if connect succeeded */
+        v = getpeername(s->fd, (struct sockaddr*)&addr, &len);
+        if (v == 0) {
+            (void)TcpIp_GetSockaddrFromBsdSocketAddr(&TcpIp_Peers[index], (const struct sockaddr*)&addr);
+            TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_CONNECTED);
+        } else {
+            TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_ALLOCATED);
+        }
+    }
+}
+
+/**
+ * @brief Hand a connection taken from the backlog of a listening socket to the upper layer
+ * @param[in] index Listening socket
+ * @param[in] id2   Slot claimed for the connection, TCPIP_SOCKETID_INVALID if none was free
+ * @param[in] fd    Accepted connection, ownership is taken over
+ * @param[in] addr  Remote address of the connection
+ */
+static void TcpIp_SocketState_Listen_Handover(TcpIp_SocketIdType index, TcpIp_SocketIdType id2, TcpIp_OsSocketType fd, const struct sockaddr_storage* addr)
+{
+    TcpIp_SocketType*  s2;
+
+    if (id2 == TCPIP_SOCKETID_INVALID) {
+        TCPIP_ACCEPT_COUNT(dropped);
+        goto cleanup;
+    }
+    TCPIP_ACCEPT_COUNT(accepted);
+    s2 = &TcpIp_Sockets[id2];
+    s2->fd = fd;
+    fd     = INVALID_SOCKET;
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+    /* stay with the worker of the shard, upper layer only knows the listening socket */
+    s2->shard_home = TcpIp_Sockets[index].shard_home;
+    if (TcpIp_Sockets[index].shard_owner != TCPIP_SOCKETID_INVALID) {
+        index = TcpIp_Sockets[index].shard_owner;
+    }
+#endif
+
+    if (TcpIp_GetSockaddrFromBsdSocketAddr(&TcpIp_Peers[id2], (const struct sockaddr*)addr) != E_OK) {
+        goto cleanup;
+    }
+
+    if (SoAd_TcpAccepted(TCPIP_SOCKET_ID(index), TCPIP_SOCKET_ID(id2), &TcpIp_Peers[id2].base) != E_OK) {
+        goto cleanup;
+    }
+
+    TcpIp_SocketState_Enter(id2, TCPIP_SOCKET_STATE_CONNECTED);
+    goto done;
+
+cleanup:
+    if (id2 != TCPIP_SOCKETID_INVALID) {
+        TcpIp_SocketState_Enter(id2, TCPIP_SOCKET_STATE_UNUSED);
     }
 
-    if (s->domain == TCPIP_AF_INET) {
-        addr.in.sin_family   = AF_INET;
-        addr.in.sin_port     = *port;
-        len = sizeof(addr.in);
-    } else if (s->domain == TCPIP_AF_INET6) {
-        addr.in6.sin6_family = AF_INET6;
-        addr.in6.sin6_port   = *port;
-        len = sizeof(addr.in6);
-    } else {
-        res = E_NOT_OK;
-        goto done;
+    if (fd != INVALID_SOCKET) {
+        TCPIP_SYSCALL_COUNT(main_function);
+        closesocket(fd);
+    }
+done:
+    return;
+}
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+/**
+ * @brief Claim a slot for a connection taken from the backlog and hand it to the upper layer
+ * @param[in] index Listening socket
+ * @param[in] fd    Accepted connection, ownership is taken over
+ * @param[in] addr  Remote address of the connection
+ */
+static void TcpIp_SocketState_Listen_Accepted(TcpIp_SocketIdType index, TcpIp_OsSocketType fd, const struct sockaddr_storage* addr)
+{
+    TcpIp_SocketType*  s   = &TcpIp_Sockets[index];
+    TcpIp_SocketIdType id2;
+
+    if (TcpIp_AllocSocket(s->domain, s->protocol, &id2) != E_OK) {
+        id2 = TCPIP_SOCKETID_INVALID;
     }
+    TcpIp_SocketState_Listen_Handover(index, id2, fd, addr);
+}
+#endif
 
-    if (bind(s->fd, (const struct sockaddr*)&addr, len) != 0) {
-        if (errno == EADDRINUSE) {
-            /** @req SWS_TCPIP_00146 */
-            TCPIP_DET_ERROR(TCPIP_API_BIND, TCPIP_E_ADDRINUSE);
+/**
+ * @brief Take up to TCPIP_CFG_ACCEPT_BUDGET pending connections from a listening socket
+ *
+ * Connections are accepted first, then slots for all of them are claimed at once.
+ *
+ * @return E_OK:     The budget was used up, more connections may be waiting
+ *         E_NOT_OK: Backlog was emptied or accept failed
+ */
+static Std_ReturnType TcpIp_SocketState_Listen_Accept(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType*       s = &TcpIp_Sockets[index];
+    TcpIp_OsSocketType      fds[TCPIP_CFG_ACCEPT_BUDGET];
+    struct sockaddr_storage addrs[TCPIP_CFG_ACCEPT_BUDGET];
+    TcpIp_SocketIdType      ids[TCPIP_CFG_ACCEPT_BUDGET];
+    uint32                  count;
+    uint32                  claimed = 0u;
+    uint32                  i;
+    socklen_t               len;
+
+    for (count = 0u; count < TCPIP_CFG_ACCEPT_BUDGET; ++count) {
+        len = sizeof(addrs[count]);
+        TCPIP_SYSCALL_COUNT(main_function);
+        fds[count] = accept4(s->fd, (struct sockaddr*)&addrs[count], &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fds[count] == INVALID_SOCKET) {
+            break;
         }
-        res = E_NOT_OK;
-        goto done;
     }
 
-    len = sizeof(addr);
-    if (getsockname(s->fd, (struct sockaddr*)&addr, &len) != 0) {
-        res = E_NOT_OK;
-        goto done;
+    if (count > 0u) {
+        claimed = TcpIp_AllocSockets(s->domain, s->protocol, ids, count);
     }
-    if (addr.in.sin_family == AF_INET) {
-        *port = addr.in.sin_port;
-    } else if (addr.in6.sin6_family == AF_INET6) {
-        *port = addr.in6.sin6_port;
-    } else {
-        res = E_NOT_OK;
-        goto done;
+    for (i = 0u; i < count; ++i) {
+        if (s->state != TCPIP_SOCKET_STATE_LISTEN) {
+            /* upper layer closed the listening socket from its callback */
+            if (i < claimed) {
+                TcpIp_FreeSocket_Release(ids[i]);
+            }
+            TCPIP_SYSCALL_COUNT(main_function);
+            closesocket(fds[i]);
+            continue;
+        }
+        TcpIp_SocketState_Listen_Handover(index, (i < claimed) ? ids[i] : TCPIP_SOCKETID_INVALID, fds[i], &addrs[i]);
     }
 
-    res = E_OK;
-    TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_BOUND);
-
-done:
-    return res;
+    if ((count == TCPIP_CFG_ACCEPT_BUDGET) && (s->state == TCPIP_SOCKET_STATE_LISTEN)) {
+        return E_OK;
+    }
+    return E_NOT_OK;
 }
 
+#if(TCPIP_CFG_ENABLE_ACCEPT_STATS == STD_ON)
 /**
- * @brief By this API service the TCP/IP stack is requested to establish a TCP connection to the configured peer.
- * @warn Reentrant for different SocketIds. Non reentrant for the same SocketId.
- * @info Asynchronous
- * @req  SWS_TCPIP_00022
+ * @brief Record a readiness event that used up the accept budget, along with the backlog length
  *
- * @param[in] id     Socket identifier of the related local socket resource.
- * @param[in] remote IP address and port of the remote host to connect to.
- * @return E_OK:     The request has been accepted
- *         E_NOT_OK: The request has not been accepted, e.g. connection
- *                   is already established or no route to destination specified by
- *                   remoteAddrPtr found.
+ * Only a full batch is worth the extra system call. The backlog it was taken from
+ * is what remains plus the batch. Once the backlog is at its limit the kernel
+ * drops further handshakes.
  */
-Std_ReturnType TcpIp_TcpConnect(
-        TcpIp_SocketIdType          id,
-        const TcpIp_SockAddrType*   remote
-    )
+static void TcpIp_AcceptStats_Budget(TcpIp_SocketIdType index)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    Std_ReturnType    res;
-
-    struct sockaddr_storage  addr;
-    socklen_t                addr_len;
+    struct tcp_info info;
+    socklen_t       len = sizeof(info);
+    uint32          backlog;
+    uint32          max;
 
-    TCPIP_DET_CHECK_RET(remote != NULL_PTR, TCPIP_API_TCPCONNECT, TCPIP_E_PARAM_POINTER);
+    TCPIP_ACCEPT_COUNT(budget_exhausted);
 
-    if (remote->domain != s->domain) {
-        return E_NOT_OK;
+    TCPIP_SYSCALL_COUNT(main_function);
+    if (getsockopt(TcpIp_Sockets[index].fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0) {
+        return;
     }
 
-    if (TcpIp_GetBsdSockaddrFromSocketAddr(&addr, &addr_len, remote) != E_OK) {
-        return E_NOT_OK;
+    /* a listening socket reports its backlog length and limit in these */
+    backlog = info.tcpi_unacked + TCPIP_CFG_ACCEPT_BUDGET;
+    if (backlog >= info.tcpi_sacked) {
+        TCPIP_ACCEPT_COUNT(backlog_full);
     }
-
-    if (TcpIp_SetBlockingState(s->fd, FALSE) != E_OK) {
-        return E_NOT_OK;
+    max = __atomic_load_n(&TcpIp_AcceptStats.backlog_max, __ATOMIC_RELAXED);
+    while ((backlog > max)
+        && !__atomic_compare_exchange_n(&TcpIp_AcceptStats.backlog_max, &max, backlog, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        /* lost against another worker, max was reloaded */
     }
+}
+#else
+#define TcpIp_AcceptStats_Budget(index)
+#endif
 
-    int v = connect(s->fd, (const struct sockaddr*)&addr, addr_len);
-    if (v != 0) {
-        v = errno;
-    }
+void TcpIp_SocketState_Listen(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    struct pollfd*    p = &TcpIp_PollFds[index];
 
-    if (v == 0) {
-        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_CONNECTED);
-    } else if(v == EINPROGRESS) {
-        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_CONNECTING);
-    } else {
-        return E_NOT_OK;
+    if ((p->revents & POLLHUP) || (p->revents & POLLERR)) {
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+        if (s->shard_owner != TCPIP_SOCKETID_INVALID) {
+            /* the other shards carry on, the slot is released with the listening socket */
+            TcpIp_SocketEvents_Update(index, 0);
+            return;
+        }
+#endif
+        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+        return;
     }
 
-    return E_OK;
+    if (p->revents & POLLIN) {
+#if(TCPIP_CFG_ENABLE_EPOLL_EDGE == STD_ON)
+        /* the edge is reported once, so the backlog is drained whatever the budget */
+        if (TcpIp_SocketState_Listen_Accept(index) == E_OK) {
+            TcpIp_AcceptStats_Budget(index);
+            while ((s->state == TCPIP_SOCKET_STATE_LISTEN) && (TcpIp_SocketState_Listen_Accept(index) == E_OK)) {
+                /* drain backlog */
+            }
+        }
+#else
+        if (TcpIp_SocketState_Listen_Accept(index) == E_OK) {
+            /* rest is left for the next main function */
+            TcpIp_AcceptStats_Budget(index);
+        }
+#endif
+    }
 }
 
 /**
- * @brief By this API service the TCP/IP stack is requested to listen on the TCP socket specified by the socket identifier.
- * @warn Reentrant for different SocketIds. Non reentrant for the same SocketId.
- * @info Asynchronous
- * @req  SWS_TCPIP_00023
- *
- * @param[in] id       Socket identifier of the related local socket resource.
- * @param[in) channels Maximum number of new parallel connections established on
- *                     this listen connection.
+ * @brief Forward received data to upper layer
  *
- * @return E_OK:     The request has been accepted
- *         E_NOT_OK: Maximum number of new parallel connections established on
- *                   this listen connection.
+ * Pooled buffers are lent out and only returned here if upper layer declines them.
  */
-Std_ReturnType TcpIp_TcpListen(
-        TcpIp_SocketIdType id,
-        uint16             channels
-    )
+static void TcpIp_RxIndication(TcpIp_SocketIdType id, const TcpIp_SockAddrType* remote, uint8* buf, uint16 len)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    Std_ReturnType    res;
-
-    /**
-     * @req SWS_TCPIP_00113
-     * @req SWS_TCPIP_00114
-     */
-    if (listen(s->fd, channels) == 0) {
-        res = E_OK;
-        TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_LISTEN);
-    } else {
-        res = E_NOT_OK;
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    uint16 index;
+
+    if (TcpIp_RxPool_Index(buf, &index) == E_OK) {
+        /* lent before the indication, upper layer may release it from within */
+        __atomic_store_n(&TcpIp_RxPoolLent[index], TRUE, __ATOMIC_RELEASE);
+        if ((remote != NULL_PTR)
+         && (SoAd_RxIndicationLoan(TCPIP_SOCKET_ID(id), remote, buf, len) == E_OK)) {
+            __atomic_fetch_add(&TcpIp_RxPoolLoaned, 1u, __ATOMIC_RELAXED);
+        } else if (__atomic_exchange_n(&TcpIp_RxPoolLent[index], FALSE, __ATOMIC_ACQ_REL)) {
+            TcpIp_RxPool_Put(index);
+        }
+        return;
+    }
+#endif
+    if (remote != NULL_PTR) {
+        SoAd_RxIndication(TCPIP_SOCKET_ID(id), remote, buf, len);
     }
-    return res;
 }
 
 /**
- * @brief This service transmits data via UDP to a remote node. The transmission of the
- *        data is immediately performed with this function call by forwarding it to EthIf.
- * @warn  Reentrant for different SocketIds. Non reentrant for the same SocketId.
- * @info  Synchronous
- *
- * @param[in] id     Socket identifier of the related local socket resource.
- * @param[in] data   Pointer to a linear buffer of TotalLength bytes containing the
- *                   data to be transmitted.
- *                   In case DataPtr is a NULL_PTR, TcpIp shall retrieve data from
- *                   upper layer via callback <Up>_CopyTxData().
- * @param[in] remote IP address and port of the remote host to transmit to.
- * @param[in] len    indicates the payload size of the UDP datagram.
+ * @brief Forward the result of a receive operation to upper layer
+ * @param[in] id   Socket the data was received on
+ * @param[in] buf  Received data
+ * @param[in] v    Number of bytes received or negative errno
+ * @param[in] addr Remote address if known, otherwise family 0
+ * @return E_OK:     Data was indicated, more may be pending
+ *         E_NOT_OK: Nothing was read or the socket changed state
  */
-Std_ReturnType TcpIp_UdpTransmit(
-        TcpIp_SocketIdType        id,
-        const uint8*              data,
-        const TcpIp_SockAddrType* remote,
-        uint16                    len
-    )
+static Std_ReturnType TcpIp_SocketState_Received(TcpIp_SocketIdType id, uint8* buf, int v, struct sockaddr_storage* addr)
 {
     TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    int v;
     Std_ReturnType res;
-    struct sockaddr_storage  addr;
-    socklen_t                addr_len;
+    TcpIp_SockAddrStorageType remote;
 
-    if (remote->domain != s->domain) {
-        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_PROTOCOL);
-        return E_NOT_OK;
+    if (v < 0) {
+        v = -v;
+        res = E_NOT_OK;
+
+        if ((v == EAGAIN) || (v == EWOULDBLOCK)) {
+            /* NOP */
+        } else {
+            TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
+        }
+
+    } else if (v == 0) {
+        res = E_NOT_OK;
+
+        if (s->protocol == TCPIP_IPPROTO_TCP) {
+            if (s->state == TCPIP_SOCKET_STATE_SHUTDOWN) {
+                TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
+            } else if (s->state != TCPIP_SOCKET_STATE_FINISHED) {
+                TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_FINISHED);
+            }
+        }
+
+    } else {
+
+        if (s->protocol == TCPIP_IPPROTO_TCP) {
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+            /* reads never exceed the credit, upper layer may return it from within the indication */
+            (void)__atomic_sub_fetch(&s->rx_credit, (uint32)v, __ATOMIC_ACQ_REL);
+#endif
+            /* stream reads carry no address, the peer was stored on connect */
+            TcpIp_RxIndication(id, &TcpIp_Peers[id].base, buf, (uint16)v);
+        } else if (TcpIp_GetSockaddrFromBsdSocketAddr(&remote, (struct sockaddr *)addr) == E_OK) {
+            TcpIp_RxIndication(id, &remote.base, buf, (uint16)v);
+        } else {
+            TcpIp_RxIndication(id, NULL_PTR, buf, (uint16)v);
+        }
+        TCPIP_TIMER_ACTIVITY(id);
+        res = E_OK;
     }
+    return res;
+}
 
-    if (TcpIp_GetBsdSockaddrFromSocketAddr(&addr, &addr_len, remote) != E_OK) {
-        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_INV_ARG);
-        return E_NOT_OK;
+#if(TCPIP_CFG_ENABLE_RECVMMSG == STD_ON)
+/**
+ * @brief Read a batch of datagrams from an UDP socket and forward them to upper layer
+ * @return E_OK:     A full batch was read, more may be pending
+ *         E_NOT_OK: Socket was drained or changed state
+ */
+static Std_ReturnType TcpIp_SocketState_ReceiveBatch(TcpIp_SocketIdType id)
+{
+    TcpIp_SocketType*         s = &TcpIp_Sockets[id];
+    uint8                     buf[TCPIP_CFG_RX_BATCH][TCPIP_CFG_MAX_PACKETSIZE];
+    struct sockaddr_storage   addr[TCPIP_CFG_RX_BATCH];
+    struct iovec              iov[TCPIP_CFG_RX_BATCH];
+    struct mmsghdr            msg[TCPIP_CFG_RX_BATCH];
+    TcpIp_SockAddrStorageType remote[TCPIP_CFG_RX_BATCH];
+    TcpIp_RxBatchEntryType    entries[TCPIP_CFG_RX_BATCH];
+    uint16                    count = 0u;
+    int                       i, v;
+
+    memset(msg, 0, sizeof(msg));
+    for (i = 0; i < (int)TCPIP_CFG_RX_BATCH; ++i) {
+        iov[i].iov_base               = buf[i];
+        iov[i].iov_len                = TcpIp_PacketSize;
+        msg[i].msg_hdr.msg_name       = &addr[i];
+        msg[i].msg_hdr.msg_namelen    = sizeof(addr[i]);
+        msg[i].msg_hdr.msg_iov        = &iov[i];
+        msg[i].msg_hdr.msg_iovlen     = 1u;
     }
 
-    if (TcpIp_SetBlockingState(s->fd, TRUE) != E_OK) {
-        return E_NOT_OK;
+    TCPIP_SYSCALL_COUNT(main_function);
+    v = recvmmsg(s->fd, msg, TCPIP_CFG_RX_BATCH, MSG_DONTWAIT, NULL);
+    if (v <= 0) {
+        return TcpIp_SocketState_Received(id, NULL, (v == -1) ? -errno : -EAGAIN, NULL);
     }
 
-    if (data) {
-        v = sendto(s->fd, data, len, 0, (struct sockaddr *)&addr, addr_len);
-    } else {
-        if (len > sizeof(s->tx_buf)) {
-            return E_NOT_OK;
+    for (i = 0; i < v; ++i) {
+        /* empty datagrams are not indicated, same as the single packet path */
+        if (msg[i].msg_len == 0u) {
+            continue;
         }
-        if (SoAd_CopyTxData(s->fd, s->tx_buf, len) != BUFREQ_OK) {
-            return E_NOT_OK;
+        if (TcpIp_GetSockaddrFromBsdSocketAddr(&remote[count], (struct sockaddr *)&addr[i]) != E_OK) {
+            continue;
         }
-        v = sendto(s->fd, s->tx_buf, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+        entries[count].remote = &remote[count].base;
+        entries[count].buf    = buf[i];
+        entries[count].len    = (uint16)msg[i].msg_len;
+        count++;
     }
+    TCPIP_TIMER_ACTIVITY(id);
 
-    if (v == -1) {
-        if (errno == EMSGSIZE) {
-            TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
-        }
-        return E_NOT_OK;
-    } else if (v != len) {
-        TCPIP_DET_ERROR(TCPIP_API_UDPTRANSMIT, TCPIP_E_MSGSIZE);
-        return E_NOT_OK;
-    } else {
-        len -= v;
+#if(TCPIP_CFG_ENABLE_RX_BATCH_INDICATION == STD_ON)
+    if (count > 0u) {
+        SoAd_RxIndicationBatch(TCPIP_SOCKET_ID(id), entries, count);
+    }
+#else
+    for (i = 0; i < (int)count; ++i) {
+        SoAd_RxIndication(TCPIP_SOCKET_ID(id), entries[i].remote, entries[i].buf, entries[i].len);
     }
+#endif
 
-    return E_OK;
+    return (v == (int)TCPIP_CFG_RX_BATCH) ? E_OK : E_NOT_OK;
 }
+#endif
 
-Std_ReturnType TcpIp_TcpTransmit(
-        TcpIp_SocketIdType  id,
-        const uint8*        data,
-        uint32              available,
-        boolean             force
-    )
+#if(TCPIP_CFG_ENABLE_UDP_GRO == STD_ON)
+/**
+ * @brief Read a run of datagrams coalesced by UDP_GRO and indicate them one by one
+ * @return E_OK:     Data was indicated, more may be pending
+ *         E_NOT_OK: Nothing was read or the socket changed state
+ */
+static Std_ReturnType TcpIp_SocketState_ReceiveGro(TcpIp_SocketIdType id)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    Std_ReturnType res;
+    TcpIp_SocketType*         s = &TcpIp_Sockets[id];
+    uint8                     buf[TCPIP_CFG_UDP_GRO_SIZE];
+    uint8                     control[CMSG_SPACE(sizeof(int))];
+    struct sockaddr_storage   addr;
+    struct iovec              iov;
+    struct msghdr             msg;
+    struct cmsghdr*           cmsg;
+    TcpIp_SockAddrStorageType remote;
+    uint32                    segment, offset, len;
+    int                       v, gso;
+#if(TCPIP_CFG_ENABLE_RX_BATCH_INDICATION == STD_ON)
+    TcpIp_RxBatchEntryType    entries[TCPIP_CFG_RX_BATCH];
+    uint16                    count = 0u;
+#endif
 
-    if (TcpIp_SetBlockingState(s->fd, TRUE) != E_OK) {
-        return E_NOT_OK;
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base       = buf;
+    iov.iov_len        = sizeof(buf);
+    msg.msg_name       = &addr;
+    msg.msg_namelen    = sizeof(addr);
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1u;
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+
+    TCPIP_SYSCALL_COUNT(main_function);
+    v = recvmsg(s->fd, &msg, MSG_DONTWAIT);
+    if (v <= 0) {
+        return TcpIp_SocketState_Received(id, NULL, (v == -1) ? -errno : v, NULL);
     }
 
-    do {
-        BufReq_ReturnType r;
-        uint16            len;
-
-        /* deduce how much we copy each time */
-        if (available < sizeof(s->tx_buf)) {
-            len = (uint16)available;
-        } else {
-            len = sizeof(s->tx_buf);
-        }
-        available -= len;
-
-        if (data == NULL) {
-            r = SoAd_CopyTxData(id, s->tx_buf, len);
-            if (r == BUFREQ_E_BUSY) {
-                return E_OK;
-            } else if (r != BUFREQ_OK) {
-                return E_NOT_OK;
+    /* a single datagram comes without segment size */
+    segment = (uint32)v;
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if ((cmsg->cmsg_level == SOL_UDP) && (cmsg->cmsg_type == UDP_GRO)) {
+            memcpy(&gso, CMSG_DATA(cmsg), sizeof(gso));
+            if (gso > 0) {
+                segment = (uint32)gso;
             }
-            data = s->tx_buf;
         }
+    }
 
-        /* we must enqueue all data we copied */
-        while (len > 0u) {
-            int v = send(s->fd, data, len, 0);
-            if (v == -1) {
-                v = errno;
-                if (v == EINTR) {
-                    continue;
-                } else {
-                    return E_NOT_OK;
-                }
-            } else {
-                len  -= v;
-                data += v;
-            }
+    TCPIP_TIMER_ACTIVITY(id);
+    if (TcpIp_GetSockaddrFromBsdSocketAddr(&remote, (struct sockaddr *)&addr) != E_OK) {
+        return E_OK;
+    }
+
+    for (offset = 0u; offset < (uint32)v; offset += segment) {
+        len = (uint32)v - offset;
+        if (len > segment) {
+            len = segment;
+        }
+        /* same truncation as a single read into a packet sized buffer */
+        if (len > TcpIp_PacketSize) {
+            len = TcpIp_PacketSize;
+        }
+#if(TCPIP_CFG_ENABLE_RX_BATCH_INDICATION == STD_ON)
+        entries[count].remote = &remote.base;
+        entries[count].buf    = &buf[offset];
+        entries[count].len    = (uint16)len;
+        if (++count == TCPIP_CFG_RX_BATCH) {
+            SoAd_RxIndicationBatch(TCPIP_SOCKET_ID(id), entries, count);
+            count = 0u;
         }
-        data = NULL;
-
-    } while (available > 0u && force);
-
+#else
+        SoAd_RxIndication(TCPIP_SOCKET_ID(id), &remote.base, &buf[offset], (uint16)len);
+#endif
+    }
+#if(TCPIP_CFG_ENABLE_RX_BATCH_INDICATION == STD_ON)
+    if (count > 0u) {
+        SoAd_RxIndicationBatch(TCPIP_SOCKET_ID(id), entries, count);
+    }
+#endif
     return E_OK;
 }
+#endif
 
-Std_ReturnType TcpIp_TcpReceived(
-        TcpIp_SocketIdType id,
-        uint32             len
-    )
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+/**
+ * @brief Indicate read ahead data of a TCP socket as far as credit allows, refill once drained
+ * @return E_OK:     Read ahead data was drained, more may be pending
+ *         E_NOT_OK: Nothing was read, credit ran out or the socket changed state
+ */
+static Std_ReturnType TcpIp_SocketState_ReceiveRing(TcpIp_SocketIdType id)
 {
-    /* TODO */
-    return E_OK;
+    TcpIp_SocketType*     s     = &TcpIp_Sockets[id];
+    TcpIp_RxRingType*     r     = &TcpIp_RxRings[id];
+    uint8*                data  = &TcpIp_RxRingData[(uint32)id * TCPIP_CFG_RX_RING_SIZE];
+    TcpIp_SocketStateType state = s->state;
+    uint32                len;
+    int                   v;
+
+    if (r->head == r->tail) {
+        if (TcpIp_RxCredit_Limit(id, 1u) == 0u) {
+            return E_NOT_OK;
+        }
+        TCPIP_SYSCALL_COUNT(main_function);
+        v = recv(s->fd, data, TCPIP_CFG_RX_RING_SIZE, MSG_DONTWAIT);
+        if (v <= 0) {
+            return TcpIp_SocketState_Received(id, NULL, (v == -1) ? -errno : 0, NULL);
+        }
+        r->head = 0u;
+        r->tail = (uint32)v;
+    }
+
+    while ((r->head != r->tail) && (s->state == state)) {
+        len = r->tail - r->head;
+        if (len > TcpIp_PacketSize) {
+            len = TcpIp_PacketSize;
+        }
+        len = TcpIp_RxCredit_Limit(id, len);
+        if (len == 0u) {
+            return E_NOT_OK;
+        }
+        r->head += len;
+        (void)TcpIp_SocketState_Received(id, &data[r->head - len], (int)len, NULL);
+    }
+    return (s->state == state) ? E_OK : E_NOT_OK;
 }
+#endif
 
-static Std_ReturnType TcpIp_GetFreeSocket(TcpIp_SocketIdType* socketid)
+/**
+ * @brief Read one packet from socket and forward it to upper layer
+ * @return E_OK:     Data was indicated, more may be pending
+ *         E_NOT_OK: Nothing was read or the socket changed state
+ */
+Std_ReturnType TcpIp_SocketState_Receive(TcpIp_SocketIdType id)
 {
-    TcpIp_SocketIdType index;
-    Std_ReturnType     res;
+    TcpIp_SocketType* s = &TcpIp_Sockets[id];
+    uint8 buf[TCPIP_CFG_MAX_PACKETSIZE];
+    uint8* data = buf;
+    uint32 size = TcpIp_PacketSize;
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    uint8* loan;
+    uint16 index;
+#endif
+    int   v;
+    socklen_t len;
+    struct sockaddr_storage addr = {0};
+    len = sizeof(addr);
 
-    for (index = 0u; index < TCPIP_CFG_MAX_SOCKETS; ++index) {
-        if (TcpIp_Sockets[index].state == TCPIP_SOCKET_STATE_UNUSED) {
-            break;
-        }
+#if(TCPIP_CFG_ENABLE_RECVMMSG == STD_ON)
+    if (s->protocol == TCPIP_IPPROTO_UDP) {
+        return TcpIp_SocketState_ReceiveBatch(id);
     }
-    if (index < TCPIP_CFG_MAX_SOCKETS) {
-        *socketid = index;
-        res = E_OK;
-    } else {
-        res = E_NOT_OK;
+#endif
+#if(TCPIP_CFG_ENABLE_UDP_GRO == STD_ON)
+    if (s->protocol == TCPIP_IPPROTO_UDP) {
+        return TcpIp_SocketState_ReceiveGro(id);
     }
-    return res;
-}
+#endif
 
-Std_ReturnType TcpIp_SoAdGetSocket(
-        TcpIp_DomainType    domain,
-        TcpIp_ProtocolType  protocol,
-        TcpIp_SocketIdType* socketid
-    )
-{
-    Std_ReturnType     res;
-
-    res = TcpIp_GetFreeSocket(socketid);
-    if (res == E_OK) {
-        TcpIp_SocketType*  s = &TcpIp_Sockets[*socketid];
-        TcpIp_OsSocketType fd;
-        fd = socket( TcpIp_GetBsdDomainFromDomain(domain)
-                   , TcpIp_GetBsdTypeFromProtocol(protocol)
-                   , 0);
-
-        if (fd != INVALID_SOCKET) {
-            s->fd       = fd;
-            s->state    = TCPIP_SOCKET_STATE_ALLOCATED;
-            s->protocol = protocol;
-            s->domain   = domain;
-        } else {
-            res = E_NOT_OK;
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+    if (s->protocol == TCPIP_IPPROTO_TCP) {
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+        return TcpIp_SocketState_ReceiveRing(id);
+#else
+        size = TcpIp_RxCredit_Limit(id, size);
+        if (size == 0u) {
+            return E_NOT_OK;
         }
+#endif
     }
+#endif
 
-    return res;
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    /* with the pool exhausted the stack buffer is used and copied from */
+    loan = TcpIp_RxPool_Get();
+    if (loan != NULL) {
+        data = loan;
+    }
+#endif
+
+    TCPIP_SYSCALL_COUNT(main_function);
+    v = recvfrom(s->fd, data, size, MSG_DONTWAIT, (struct sockaddr *)&addr, &len);
+    if (v == -1) {
+        v = -errno;
+    }
+#if(TCPIP_CFG_ENABLE_RX_LOAN == STD_ON)
+    /* nothing was indicated, so the loan is still ours */
+    if ((loan != NULL) && (v <= 0) && (TcpIp_RxPool_Index(loan, &index) == E_OK)) {
+        TcpIp_RxPool_Put(index);
+    }
+#endif
+    return TcpIp_SocketState_Received(id, data, v, &addr);
 }
 
 /**
- * @brief By this API service the TCP/IP stack is requested to change a parameter of a socket. E.g. the Nagle algorithm may be controlled by this API.
- * @req SWS_TCPIP_00016
- * @req SWS_TCPIP_00119
+ * @brief Read pending data from a socket signalled readable
+ *
+ * In edge triggered mode the socket is not reported again until it has
+ * been drained, so keep reading until EAGAIN or a state change.
  */
-Std_ReturnType TcpIp_ChangeParameter(
-        TcpIp_SocketIdType id,
-        TcpIp_ParamIdType  parm,
-        const uint8*       value
-    )
+static void TcpIp_SocketState_ReceiveAll(TcpIp_SocketIdType index)
 {
-    Std_ReturnType     res;
-    TcpIp_SocketType*  s = &TcpIp_Sockets[id];
-
-    switch (id) {
-        case TCPIP_PARAMID_TCP_KEEPALIVE: {
-            int v = *value;
-            if (setsockopt(s->fd, SOL_SOCKET, SO_KEEPALIVE, &v, sizeof(v)) == 0) {
-                res = E_OK;
-            } else {
-                res = E_NOT_OK;
-            }
-            break;
-        }
-        default:
-            res = E_NOT_OK;
+#if(TCPIP_CFG_ENABLE_EPOLL_EDGE == STD_ON)
+    TcpIp_SocketType*     s     = &TcpIp_Sockets[index];
+    TcpIp_SocketStateType state = s->state;
+    while ((TcpIp_SocketState_Receive(index) == E_OK) && (s->state == state)) {
+        /* drain socket */
     }
-
-    return res;
+#else
+    (void)TcpIp_SocketState_Receive(index);
+#endif
 }
 
-void TcpIp_SocketState_Connecting(TcpIp_SocketIdType index)
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+/**
+ * @brief Read again from sockets that got credit back, called by the main function only
+ */
+static void TcpIp_RxCredit_Resume(void)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[index];
-    struct pollfd*    p = &TcpIp_PollFds[index];
-    int v;
+    TcpIp_SocketIdType index;
+    TcpIp_SocketType*  s;
 
-    if ((p->revents & POLLHUP) || (p->revents & POLLERR)) {
-        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+    if (!__atomic_exchange_n(&TcpIp_RxResume, FALSE, __ATOMIC_ACQ_REL)) {
         return;
     }
 
-    if (p->revents & POLLOUT) {
-        struct sockaddr_storage addr;
-        socklen_t len = sizeof(addr);
+    for (index = 0u; index < TcpIp_SocketCount; ++index) {
+        s = &TcpIp_Sockets[index];
+        if (!s->rx_paused || (__atomic_load_n(&s->rx_credit, __ATOMIC_ACQUIRE) == 0u)) {
+            continue;
+        }
+        s->rx_paused = FALSE;
 
-        /* check if connect succeeded */
-        v = getpeername(s->fd, (struct sockaddr*)&addr, &len);
-        if (v == 0) {
-            TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_CONNECTED);
-        } else {
-            TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_ALLOCATED);
+        if ((s->state != TCPIP_SOCKET_STATE_CONNECTED) && (s->state != TCPIP_SOCKET_STATE_SHUTDOWN)) {
+            continue;
         }
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+        TcpIp_Uring_Arm(index);
+#else
+        TcpIp_SocketEvents_Update(index, TcpIp_SocketEvents_Stream(index));
+#if(TCPIP_CFG_RX_RING_SIZE > 0u)
+        /* the socket does not signal data already read ahead */
+        TcpIp_SocketState_ReceiveAll(index);
+#endif
+#endif
     }
 }
+#endif
 
-void TcpIp_SocketState_Listen_Accept(TcpIp_SocketIdType index)
+void TcpIp_SocketState_Shutdown(TcpIp_SocketIdType index)
 {
-    TcpIp_SocketType*  s   = &TcpIp_Sockets[index];
-    TcpIp_SocketType*  s2;
-    TcpIp_SocketIdType id2 = TCPIP_SOCKETID_INVALID;
-    int fd                 = INVALID_SOCKET;
-
-    socklen_t len;
-    struct sockaddr_storage addr;
-    len = sizeof(addr);
-
-    TcpIp_SockAddrStorageType data;
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    struct pollfd*    p = &TcpIp_PollFds[index];
 
-    fd = accept(s->fd, (struct sockaddr*)&addr, &len);
-    if (fd == INVALID_SOCKET) {
-        goto cleanup;
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+    if ((p->revents & POLLERR) && TcpIp_Zerocopy_Reap(index)) {
+        p->revents &= ~POLLERR;
     }
-
-    if (TcpIp_SoAdGetSocket(s->domain, s->protocol, &id2) != E_OK) {
-        goto cleanup;
+#endif
+    if (p->revents & POLLERR) {
+        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+        return;
     }
-    s2 = &TcpIp_Sockets[id2];
-    s2->fd = fd;
 
-    if (TcpIp_GetSockaddrFromBsdSocketAddr(&data, (struct sockaddr*)&addr) != E_OK) {
-        goto cleanup;
+    if ((p->revents & POLLIN) || (p->revents & POLLHUP)) {
+        TcpIp_SocketState_ReceiveAll(index);
     }
 
-    if (SoAd_TcpAccepted(index, id2, &data.base) != E_OK) {
-        goto cleanup;
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+    if ((p->revents & POLLOUT) && (s->state == TCPIP_SOCKET_STATE_SHUTDOWN)) {
+        TcpIp_TcpTx_Poll(index);
     }
+#endif
+}
 
-    TcpIp_SocketState_Enter(id2, TCPIP_SOCKET_STATE_CONNECTED);
-    goto done;
+void TcpIp_SocketState_Bound(TcpIp_SocketIdType index)
+{
+    TcpIp_SocketType* s = &TcpIp_Sockets[index];
+    struct pollfd*    p = &TcpIp_PollFds[index];
 
-cleanup:
-    if (id2 != TCPIP_SOCKETID_INVALID) {
-        TcpIp_SocketState_Enter(id2, TCPIP_SOCKET_STATE_UNUSED);
+    if ((p->revents & POLLHUP) || (p->revents & POLLERR)) {
+        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+        return;
     }
 
-    if (fd != INVALID_SOCKET) {
-        closesocket(fd);
+    if (p->revents & POLLIN) {
+        TcpIp_SocketState_ReceiveAll(index);
     }
-done:
-    return;
 }
 
-void TcpIp_SocketState_Listen(TcpIp_SocketIdType index)
+void TcpIp_SocketState_Connected(TcpIp_SocketIdType index)
 {
     TcpIp_SocketType* s = &TcpIp_Sockets[index];
     struct pollfd*    p = &TcpIp_PollFds[index];
 
-    if ((p->revents & POLLHUP) || (p->revents & POLLERR)) {
+#if(TCPIP_CFG_ENABLE_ZEROCOPY == STD_ON)
+    /* completions of zerocopy sends raise POLLERR, only other errors are fatal */
+    if ((p->revents & POLLERR) && TcpIp_Zerocopy_Reap(index)) {
+        p->revents &= ~POLLERR;
+    }
+#endif
+    if (p->revents & POLLERR) {
         TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
         return;
     }
 
-    if (p->revents & POLLIN) {
-        TcpIp_SocketState_Listen_Accept(index);
+    if ((p->revents & POLLIN) || (p->revents & POLLHUP)) {
+        TcpIp_SocketState_ReceiveAll(index);
+    }
+
+    if (s->state == TCPIP_SOCKET_STATE_CONNECTED) {
+#if(TCPIP_CFG_ENABLE_TCP_TX_BUFFER == STD_ON)
+        /* sends what the kernel takes and updates the events */
+        TcpIp_TcpTx_Poll(index);
+#else
+        TcpIp_SocketEvents_Update(index, TcpIp_SocketEvents_Stream(index));
+#endif
     }
 }
 
-void TcpIp_SocketState_Receive(TcpIp_SocketIdType id)
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+static uint32 TcpIp_Timer_Ticks(void)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[id];
-    uint8 buf[TCPIP_CFG_MAX_PACKETSIZE];
-    int   v;
-    socklen_t len;
-    struct sockaddr_storage addr = {0};
-    len = sizeof(addr);
+    struct timespec ts;
+    uint64          ms;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    ms = (uint64)ts.tv_sec * 1000u + (uint64)ts.tv_nsec / 1000000u;
+    return (uint32)(ms / TCPIP_CFG_TIMER_TICK);
+}
 
-    v = recvfrom(s->fd, buf, TCPIP_CFG_MAX_PACKETSIZE, 0, (struct sockaddr *)&addr, &len);
-    if (v == -1) {
-        v = errno;
+static void TcpIp_Timer_Link(TcpIp_SocketIdType index)
+{
+    TcpIp_TimerType* t     = &TcpIp_Timers[index];
+    uint32           delta = t->expires - TcpIp_TimerNow;
+    uint32           level;
+    uint16           slot;
+
+    if ((sint32)delta < 0) {
+        /* already due, lands in the slot being expired */
+        t->expires = TcpIp_TimerNow;
+        delta      = 0u;
+    } else if (delta > TCPIP_TIMER_MAX) {
+        t->expires = TcpIp_TimerNow + TCPIP_TIMER_MAX;
+        delta      = TCPIP_TIMER_MAX;
+    }
 
-        if ((v == EAGAIN) && (v == EWOULDBLOCK)) {
-            /* NOP */
-        } else {
-            TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
+    for (level = 0u; level < TCPIP_TIMER_LEVELS - 1u; ++level) {
+        if (delta < (1u << (TCPIP_TIMER_BITS * (level + 1u)))) {
+            break;
         }
+    }
+    slot = (uint16)(level * TCPIP_TIMER_SLOTS + ((t->expires >> (TCPIP_TIMER_BITS * level)) & TCPIP_TIMER_MASK));
 
-    } else if (v == 0) {
+    t->slot = slot;
+    t->prev = TCPIP_TIMER_NONE;
+    t->next = TcpIp_TimerWheel[slot];
+    if (t->next != TCPIP_TIMER_NONE) {
+        TcpIp_Timers[t->next].prev = index;
+    }
+    TcpIp_TimerWheel[slot] = index;
+}
 
-        if (s->protocol == TCPIP_IPPROTO_TCP) {
-            if (s->state == TCPIP_SOCKET_STATE_SHUTDOWN) {
-                TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_UNUSED);
-            } else {
-                TcpIp_SocketState_Enter(id, TCPIP_SOCKET_STATE_FINISHED);
-            }
-        }
+static void TcpIp_Timer_Unlink(TcpIp_SocketIdType index)
+{
+    TcpIp_TimerType* t = &TcpIp_Timers[index];
 
+    if (t->prev != TCPIP_TIMER_NONE) {
+        TcpIp_Timers[t->prev].next = t->next;
     } else {
+        TcpIp_TimerWheel[t->slot] = t->next;
+    }
+    if (t->next != TCPIP_TIMER_NONE) {
+        TcpIp_Timers[t->next].prev = t->prev;
+    }
+    t->slot = TCPIP_TIMER_NONE;
+}
 
-        TcpIp_SockAddrStorageType remote;
-        if (addr.ss_family == 0) {
-            len = sizeof(addr);
-            (void)getpeername(s->fd,  (struct sockaddr *)&addr, &len);
-        }
-        if (TcpIp_GetSockaddrFromBsdSocketAddr(&remote, (struct sockaddr *)&addr) == E_OK) {
-            SoAd_RxIndication(id, &remote.base, buf, v);
-        }
+static void TcpIp_Timer_Init(void)
+{
+    TcpIp_SocketIdType index;
+    uint32             slot;
+
+    for (slot = 0u; slot < TCPIP_TIMER_LEVELS * TCPIP_TIMER_SLOTS; ++slot) {
+        TcpIp_TimerWheel[slot] = TCPIP_TIMER_NONE;
+    }
+    for (index = 0u; index < TcpIp_SocketCount; ++index) {
+        TcpIp_Timers[index].slot = TCPIP_TIMER_NONE;
+    }
+    TcpIp_TimerNow   = TcpIp_Timer_Ticks();
+    TcpIp_TimerArmed = 0u;
+#if(TCPIP_WAKEUP_FD == STD_ON)
+    TcpIp_TimerPlannedValid = FALSE;
+#endif
 
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    if (TcpIp_TimerFd != -1) {
+        close(TcpIp_TimerFd);
+    }
+    TcpIp_TimerProgrammedValid = FALSE;
+    TcpIp_TimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (TcpIp_TimerFd == -1) {
+        TCPIP_DET_ERROR(TCPIP_API_INIT, TCPIP_E_INIT_FAILED);
+    } else {
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+        TcpIp_Uring_ArmTimer();
+#else
+        struct epoll_event ev;
+        ev.events   = EPOLLIN;
+        ev.data.u64 = TCPIP_EPOLL_TIMER;
+        (void)epoll_ctl(TcpIp_EpollFd, EPOLL_CTL_ADD, TcpIp_TimerFd, &ev);
+#endif
     }
+#endif
 }
 
-void TcpIp_SocketState_Shutdown(TcpIp_SocketIdType index)
+/**
+ * @brief Arm or cancel the timer of a socket for the state it enters
+ *
+ * Caller holds TCPIP_SOCKET_LOCK.
+ */
+static void TcpIp_Timer_Update(TcpIp_SocketIdType index, TcpIp_SocketStateType state)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[index];
-    struct pollfd*    p = &TcpIp_PollFds[index];
+    TcpIp_TimerType* t = &TcpIp_Timers[index];
+    uint32           timeout;
+    uint32           now;
 
-    if (p->revents & POLLERR) {
-        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
-        return;
+    switch (state) {
+        case TCPIP_SOCKET_STATE_CONNECTING:
+            timeout = TCPIP_CFG_CONNECT_TIMEOUT;
+            break;
+        case TCPIP_SOCKET_STATE_SHUTDOWN:
+        case TCPIP_SOCKET_STATE_FINISHED:
+            timeout = TCPIP_CFG_SHUTDOWN_TIMEOUT;
+            break;
+        case TCPIP_SOCKET_STATE_CONNECTED:
+            timeout = TCPIP_CFG_IDLE_TIMEOUT;
+            break;
+        default:
+            timeout = 0u;
+            break;
     }
 
-    if ((p->revents & POLLIN) || (p->revents & POLLHUP)) {
-        TcpIp_SocketState_Receive(index);
+    if (t->slot != TCPIP_TIMER_NONE) {
+        TcpIp_Timer_Unlink(index);
+        TcpIp_TimerArmed--;
+    }
+
+    if ((timeout != 0u) && (TcpIp_Sockets[index].protocol == TCPIP_IPPROTO_TCP)) {
+        /* the wheel only advances in the main function, count from the current tick */
+        now = TcpIp_Timer_Ticks();
+        if (TcpIp_TimerArmed == 0u) {
+            /* nothing is linked, skip ahead like TcpIp_Timer_Advance does */
+            TcpIp_TimerNow = now;
+        }
+        t->timeout  = (timeout + TCPIP_CFG_TIMER_TICK - 1u) / TCPIP_CFG_TIMER_TICK;
+        t->activity = now;
+        t->expires  = now + t->timeout;
+        TcpIp_Timer_Link(index);
+        TcpIp_TimerArmed++;
+
+#if(TCPIP_WAKEUP_FD == STD_ON)
+        if (!TcpIp_TimerPlannedValid || ((sint32)(t->expires - TcpIp_TimerPlanned) < 0)) {
+            /* a blocked wait or the programmed timerfd would only look at the wheel later */
+            TcpIp_TimerPlanned      = t->expires;
+            TcpIp_TimerPlannedValid = TRUE;
+            TCPIP_WAKEUP_SIGNAL();
+        }
+#endif
     }
 }
 
-void TcpIp_SocketState_Bound(TcpIp_SocketIdType index)
+/**
+ * @brief Move the timers of a higher level slot down as its time range comes up
+ */
+static void TcpIp_Timer_Cascade(uint32 level)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[index];
-    struct pollfd*    p = &TcpIp_PollFds[index];
+    uint16             slot  = (uint16)(level * TCPIP_TIMER_SLOTS + ((TcpIp_TimerNow >> (TCPIP_TIMER_BITS * level)) & TCPIP_TIMER_MASK));
+    TcpIp_SocketIdType index = TcpIp_TimerWheel[slot];
+
+    TcpIp_TimerWheel[slot] = TCPIP_TIMER_NONE;
+    while (index != TCPIP_TIMER_NONE) {
+        TcpIp_SocketIdType next = TcpIp_Timers[index].next;
+        TcpIp_Timer_Link(index);
+        index = next;
+    }
+}
+
+/**
+ * @brief Run the wheel up to the current time and expire due sockets
+ */
+static void TcpIp_Timer_Advance(void)
+{
+    uint32             target = TcpIp_Timer_Ticks();
+    TcpIp_SocketIdType index;
+    TcpIp_TimerType*   t;
+    uint32             level;
+
+    TCPIP_SOCKET_LOCK();
+    if (TcpIp_TimerArmed == 0u) {
+        /* nothing can expire, skip ahead */
+        TcpIp_TimerNow = target;
+    }
+
+    while ((sint32)(target - TcpIp_TimerNow) > 0) {
+        TcpIp_TimerNow++;
+
+        for (level = 1u; level < TCPIP_TIMER_LEVELS; ++level) {
+            if ((TcpIp_TimerNow & ((1u << (TCPIP_TIMER_BITS * level)) - 1u)) != 0u) {
+                break;
+            }
+            TcpIp_Timer_Cascade(level);
+        }
+
+        /* expiry changes socket state which relinks timers, take one at a time */
+        for (;;) {
+            index = TcpIp_TimerWheel[TcpIp_TimerNow & TCPIP_TIMER_MASK];
+            if (index == TCPIP_TIMER_NONE) {
+                break;
+            }
+            t = &TcpIp_Timers[index];
+            TcpIp_Timer_Unlink(index);
+            TcpIp_TimerArmed--;
+
+            if ((TcpIp_Sockets[index].state == TCPIP_SOCKET_STATE_CONNECTED)
+            &&  ((sint32)(t->activity + t->timeout - TcpIp_TimerNow) > 0)) {
+                /* there was traffic since arming, wait for the rest */
+                t->expires = t->activity + t->timeout;
+                TcpIp_Timer_Link(index);
+                TcpIp_TimerArmed++;
+                continue;
+            }
 
-    if ((p->revents & POLLHUP) || (p->revents & POLLERR)) {
-        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
-        return;
+            TCPIP_SOCKET_UNLOCK();
+            TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+            TCPIP_SOCKET_LOCK();
+        }
     }
+    TCPIP_SOCKET_UNLOCK();
 
-    if (p->revents & POLLIN) {
-        TcpIp_SocketState_Receive(index);
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    TcpIp_Timer_Program();
+#endif
+}
+
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON) || (TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+/**
+ * @brief Time until the wheel needs to advance next
+ * @return Timeout in [ms] or -1 if no timer is armed
+ */
+static int TcpIp_Timer_NextTimeout(void)
+{
+    uint32 tick;
+    uint32 ticks;
+    int    res;
+
+    TCPIP_SOCKET_LOCK();
+    if (TcpIp_TimerArmed == 0u) {
+        res = -1;
+#if(TCPIP_WAKEUP_FD == STD_ON)
+        TcpIp_TimerPlannedValid = FALSE;
+#endif
+    } else {
+        /* look for a filled slot before the next cascade */
+        for (tick = TcpIp_TimerNow + 1u; (tick & TCPIP_TIMER_MASK) != 0u; ++tick) {
+            if (TcpIp_TimerWheel[tick & TCPIP_TIMER_MASK] != TCPIP_TIMER_NONE) {
+                break;
+            }
+        }
+        ticks = tick - TcpIp_TimerNow;
+        res   = (int)(ticks * TCPIP_CFG_TIMER_TICK);
+#if(TCPIP_WAKEUP_FD == STD_ON)
+        TcpIp_TimerPlanned      = tick;
+        TcpIp_TimerPlannedValid = TRUE;
+#endif
     }
+    TCPIP_SOCKET_UNLOCK();
+    return res;
 }
+#endif
 
-void TcpIp_SocketState_Connected(TcpIp_SocketIdType index)
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+/**
+ * @brief Have the readiness file descriptor fire when the wheel next needs to advance
+ */
+static void TcpIp_Timer_Program(void)
 {
-    TcpIp_SocketType* s = &TcpIp_Sockets[index];
-    struct pollfd*    p = &TcpIp_PollFds[index];
+    struct itimerspec its;
+    int               timeout = TcpIp_Timer_NextTimeout();
+    uint32            deadline;
+    uint64            ms;
+
+    if (timeout < 0) {
+        if (!TcpIp_TimerProgrammedValid) {
+            return;
+        }
+        memset(&its, 0, sizeof(its));
+        TcpIp_TimerProgrammedValid = FALSE;
+        TCPIP_SYSCALL_COUNT(main_function);
+        (void)timerfd_settime(TcpIp_TimerFd, 0, &its, NULL);
+        return;
+    }
 
-    if (p->revents & POLLERR) {
-        TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+    deadline = TcpIp_TimerNow + (uint32)timeout / TCPIP_CFG_TIMER_TICK;
+    if (TcpIp_TimerProgrammedValid && (TcpIp_TimerProgrammed == deadline)) {
         return;
     }
 
-    if ((p->revents & POLLIN) || (p->revents & POLLHUP)) {
-        TcpIp_SocketState_Receive(index);
+    /* tick count wraps, so express the deadline relative to now */
+    ms = (uint64)timeout;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec  = (time_t)(ms / 1000u);
+    its.it_value.tv_nsec = (long)((ms % 1000u) * 1000000u);
+    TCPIP_SYSCALL_COUNT(main_function);
+    if (timerfd_settime(TcpIp_TimerFd, 0, &its, NULL) == 0) {
+        TcpIp_TimerProgrammed      = deadline;
+        TcpIp_TimerProgrammedValid = TRUE;
     }
+}
 
-    p->events = POLLIN;
+#if(TCPIP_CFG_ENABLE_URING == STD_OFF)
+static void TcpIp_Timer_Clear(void)
+{
+    uint64 v;
+    TCPIP_SYSCALL_COUNT(main_function);
+    (void)read(TcpIp_TimerFd, &v, sizeof(v));
+    TcpIp_TimerProgrammedValid = FALSE;
 }
+#endif
+#endif
+#endif
 
 static void TcpIp_SocketState_Enter(TcpIp_SocketIdType index, TcpIp_SocketStateType state)
 {
     TcpIp_SocketType* s = &TcpIp_Sockets[index];
-    struct pollfd*    p = &TcpIp_PollFds[index];
-
 
     /* what events are we listening on */
     switch (state) {
         case TCPIP_SOCKET_STATE_CONNECTING:
-            p->events = POLLOUT;
+            TcpIp_SocketEvents_Update(index, POLLOUT);
             break;
         case TCPIP_SOCKET_STATE_CONNECTED:
-            SoAd_TcpConnected(index);
-            p->events = POLLIN;
+            SoAd_TcpConnected(TCPIP_SOCKET_ID(index));
+            TcpIp_SocketEvents_Update(index, TcpIp_SocketEvents_Stream(index));
             break;
-        case TCPIP_SOCKET_STATE_LISTEN:
         case TCPIP_SOCKET_STATE_SHUTDOWN:
+            TcpIp_SocketEvents_Update(index, TcpIp_SocketEvents_Stream(index));
+            break;
+        case TCPIP_SOCKET_STATE_LISTEN:
         case TCPIP_SOCKET_STATE_BOUND:
-            p->events = POLLIN;
+            TcpIp_SocketEvents_Update(index, POLLIN);
             break;
 
         case TCPIP_SOCKET_STATE_FINISHED:
-            SoAd_TcpIpEvent(index, TCPIP_TCP_FIN_RECEIVED);
-            p->events = POLLIN;
+            SoAd_TcpIpEvent(TCPIP_SOCKET_ID(index), TCPIP_TCP_FIN_RECEIVED);
+            TcpIp_SocketEvents_Update(index, POLLIN);
             break;
 
         case TCPIP_SOCKET_STATE_UNUSED:
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+            if (s->shard_owner != TCPIP_SOCKETID_INVALID) {
+                /* unknown to the upper layer */
+            } else
+#endif
             if (s->protocol == TCPIP_IPPROTO_UDP) {
-                SoAd_TcpIpEvent(index, TCPIP_UDP_CLOSED);
+                SoAd_TcpIpEvent(TCPIP_SOCKET_ID(index), TCPIP_UDP_CLOSED);
             } else if (s->protocol == TCPIP_IPPROTO_TCP) {
                 if (s->state == TCPIP_SOCKET_STATE_CONNECTED) {
-                    SoAd_TcpIpEvent(index, TCPIP_TCP_RESET);
+                    SoAd_TcpIpEvent(TCPIP_SOCKET_ID(index), TCPIP_TCP_RESET);
                 } else {
-                    SoAd_TcpIpEvent(index, TCPIP_TCP_CLOSED);
+                    SoAd_TcpIpEvent(TCPIP_SOCKET_ID(index), TCPIP_TCP_CLOSED);
                 }
             }
 
+            TcpIp_SocketEvents_Update(index, 0);
             if (s->fd != INVALID_SOCKET) {
+                TCPIP_SYSCALL_COUNT(close);
                 closesocket(s->fd);
                 s->fd = INVALID_SOCKET;
             }
-            p->events = 0;
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+            if (s->shard_owner == TCPIP_SOCKETID_INVALID) {
+                TcpIp_ListenShards_Close(index);
+            }
+#endif
             break;
         default:
-            p->events = 0;
+            TcpIp_SocketEvents_Update(index, 0);
             break;
     }
 
+    /* slot may be claimed by a concurrent TcpIp_SoAdGetSocket once unused */
+    TCPIP_SOCKET_LOCK();
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TcpIp_Timer_Update(index, state);
+#endif
+    if ((state == TCPIP_SOCKET_STATE_UNUSED) && (s->state != TCPIP_SOCKET_STATE_UNUSED)) {
+        TcpIp_FreeSocket_Push(index);
+    }
     s->state = state;
+    TCPIP_SOCKET_UNLOCK();
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    TcpIp_Uring_Arm(index);
+#endif
 }
 
 static void TcpIp_SocketState_All(TcpIp_SocketIdType index)
@@ -992,17 +5827,422 @@ static void TcpIp_SocketState_All(TcpIp_SocketIdType index)
 
 }
 
-void TcpIp_MainFunction(void)
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+/**
+ * @brief Ready sockets assigned to one worker
+ *
+ * The owner takes from the tail, idle workers steal from the head.
+ */
+typedef struct {
+    pthread_mutex_t    lock;
+    TcpIp_SocketIdType* items;
+    uint32             head;
+    uint32             tail;
+    uint32             generation;
+} TcpIp_WorkerQueueType;
+
+TcpIp_WorkerQueueType TcpIp_WorkerQueues[TCPIP_CFG_WORKER_THREADS];
+uint32                TcpIp_WorkerCount;
+uint32                TcpIp_WorkerPushed;
+uint32                TcpIp_WorkerGeneration;
+uint32                TcpIp_WorkerBusy;
+pthread_mutex_t       TcpIp_WorkerLock  = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t        TcpIp_WorkerStart = PTHREAD_COND_INITIALIZER;
+pthread_cond_t        TcpIp_WorkerDone  = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief Queue a ready socket, only called by the main function before the pool is started
+ */
+static void TcpIp_Worker_Push(TcpIp_SocketIdType index)
+{
+#if(TCPIP_CFG_ENABLE_LISTEN_SHARDS == STD_ON)
+    uint32                 home = TcpIp_Sockets[index].shard_home;
+    TcpIp_WorkerQueueType* q    = &TcpIp_WorkerQueues[(home != TCPIP_SHARD_NONE ? home : TcpIp_WorkerPushed) % TcpIp_WorkerCount];
+#else
+    TcpIp_WorkerQueueType* q = &TcpIp_WorkerQueues[TcpIp_WorkerPushed % TcpIp_WorkerCount];
+#endif
+    q->items[q->tail++] = index;
+    TcpIp_WorkerPushed++;
+}
+
+static boolean TcpIp_Worker_Take(uint32 self, TcpIp_SocketIdType* index)
+{
+    uint32  i;
+    boolean found = FALSE;
+
+    for (i = 0u; (i < TcpIp_WorkerCount) && !found; ++i) {
+        TcpIp_WorkerQueueType* q = &TcpIp_WorkerQueues[(self + i) % TcpIp_WorkerCount];
+        (void)pthread_mutex_lock(&q->lock);
+        if (q->head != q->tail) {
+            if (i == 0u) {
+                *index = q->items[--q->tail];
+            } else {
+                *index = q->items[q->head++];
+            }
+            found = TRUE;
+        }
+        (void)pthread_mutex_unlock(&q->lock);
+    }
+    return found;
+}
+
+static void TcpIp_Worker_Drain(uint32 self)
+{
+    TcpIp_SocketIdType index;
+    while (TcpIp_Worker_Take(self, &index)) {
+        TcpIp_SocketState_All(index);
+        TcpIp_PollFds[index].revents = 0;
+    }
+}
+
+static void* TcpIp_Worker_Main(void* arg)
+{
+    uint32 self       = (uint32)(uintptr_t)arg;
+    uint32 generation = TcpIp_WorkerQueues[self].generation;
+
+    (void)pthread_mutex_lock(&TcpIp_WorkerLock);
+    for (;;) {
+        while (generation == TcpIp_WorkerGeneration) {
+            (void)pthread_cond_wait(&TcpIp_WorkerStart, &TcpIp_WorkerLock);
+        }
+        generation = TcpIp_WorkerGeneration;
+        (void)pthread_mutex_unlock(&TcpIp_WorkerLock);
+
+        TcpIp_Worker_Drain(self);
+
+        (void)pthread_mutex_lock(&TcpIp_WorkerLock);
+        if (--TcpIp_WorkerBusy == 0u) {
+            (void)pthread_cond_signal(&TcpIp_WorkerDone);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start the worker threads, they are kept over re-initialization
+ */
+static void TcpIp_Worker_Start(void)
+{
+    uint32    i;
+    pthread_t thread;
+
+    if (TcpIp_WorkerCount == 0u) {
+        for (i = 0u; i < TCPIP_CFG_WORKER_THREADS; ++i) {
+            (void)pthread_mutex_init(&TcpIp_WorkerQueues[i].lock, NULL);
+        }
+        TcpIp_WorkerCount = 1u;
+    }
+
+    for (i = 0u; i < TCPIP_CFG_WORKER_THREADS; ++i) {
+        TcpIp_WorkerQueues[i].items = &TcpIp_WorkerItems[i * TcpIp_SocketCount];
+    }
+
+    while (TcpIp_WorkerCount < TCPIP_CFG_WORKER_THREADS) {
+        /* a thread starting late must still take part in the next run */
+        TcpIp_WorkerQueues[TcpIp_WorkerCount].generation = TcpIp_WorkerGeneration;
+        if (pthread_create(&thread, NULL, TcpIp_Worker_Main, (void*)(uintptr_t)TcpIp_WorkerCount) != 0) {
+            TCPIP_DET_ERROR(TCPIP_API_INIT, TCPIP_E_INIT_FAILED);
+            break;
+        }
+        (void)pthread_detach(thread);
+#if(TCPIP_CFG_ENABLE_SHARD_AFFINITY == STD_ON)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(TcpIp_Shard_Cpu(TcpIp_WorkerCount), &cpus);
+            (void)pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+        }
+#endif
+        TcpIp_WorkerCount++;
+    }
+}
+
+/**
+ * @brief Handle all queued sockets and return once every one is done
+ */
+static void TcpIp_Worker_Run(void)
+{
+    uint32 i;
+
+    if ((TcpIp_WorkerPushed > 1u) && (TcpIp_WorkerCount > 1u)) {
+        (void)pthread_mutex_lock(&TcpIp_WorkerLock);
+        TcpIp_WorkerGeneration++;
+        TcpIp_WorkerBusy = TcpIp_WorkerCount - 1u;
+        (void)pthread_cond_broadcast(&TcpIp_WorkerStart);
+        (void)pthread_mutex_unlock(&TcpIp_WorkerLock);
+
+        TcpIp_Worker_Drain(0u);
+
+        (void)pthread_mutex_lock(&TcpIp_WorkerLock);
+        while (TcpIp_WorkerBusy > 0u) {
+            (void)pthread_cond_wait(&TcpIp_WorkerDone, &TcpIp_WorkerLock);
+        }
+        (void)pthread_mutex_unlock(&TcpIp_WorkerLock);
+    } else {
+        /* not worth waking anyone */
+        TcpIp_Worker_Drain(0u);
+    }
+
+    for (i = 0u; i < TcpIp_WorkerCount; ++i) {
+        TcpIp_WorkerQueues[i].head = 0u;
+        TcpIp_WorkerQueues[i].tail = 0u;
+    }
+    TcpIp_WorkerPushed = 0u;
+}
+#endif
+
+/**
+ * @brief Pick up work other threads handed over to the main function
+ */
+static void TcpIp_MainFunction_Handover(void)
+{
+#if(TCPIP_CFG_ENABLE_TX_QUEUE == STD_ON)
+    TcpIp_TxQueue_Drain();
+#endif
+#if(TCPIP_CFG_ENABLE_RX_CREDIT == STD_ON)
+    TcpIp_RxCredit_Resume();
+#endif
+}
+
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+static void TcpIp_Uring_CompleteRx(TcpIp_SocketIdType index, sint32 res)
+{
+    TcpIp_SocketType*      s = &TcpIp_Sockets[index];
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+    struct pollfd*         p = &TcpIp_PollFds[index];
+
+    u->rx_pending = FALSE;
+
+    if (u->rx_cancel || (res == -ECANCELED) || (s->fd == INVALID_SOCKET)) {
+        /* request is no longer wanted, don't leak a connection accepted meanwhile */
+        if ((u->rx_opcode == IORING_OP_ACCEPT) && (res >= 0)) {
+            TCPIP_SYSCALL_COUNT(main_function);
+            closesocket(res);
+        }
+        u->rx_cancel = FALSE;
+    } else {
+        switch (u->rx_opcode) {
+            case IORING_OP_ACCEPT:
+                if (res >= 0) {
+                    TcpIp_SocketState_Listen_Accepted(index, res, &u->rx_addr);
+                } else if ((res != -ECONNABORTED) && (res != -EMFILE) && (res != -ENFILE)
+                        && (res != -ENOBUFS)      && (res != -ENOMEM) && (res != -EINTR)) {
+                    TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+                }
+                break;
+            case IORING_OP_RECV:
+                u->rx_addr.ss_family = 0;
+                (void)TcpIp_SocketState_Received(index, u->rx_buf, res, &u->rx_addr);
+                break;
+            case IORING_OP_RECVMSG:
+                (void)TcpIp_SocketState_Received(index, u->rx_buf, res, &u->rx_addr);
+                break;
+            default:
+                p->revents = (res < 0) ? POLLERR : (short)res;
+                TcpIp_SocketState_All(index);
+                p->revents = 0;
+                break;
+        }
+    }
+
+    TcpIp_Uring_Arm(index);
+}
+
+static void TcpIp_Uring_CompleteTx(TcpIp_SocketIdType index, sint32 res)
+{
+    TcpIp_SocketType*      s = &TcpIp_Sockets[index];
+    TcpIp_UringSocketType* u = &TcpIp_UringSockets[index];
+    TcpIp_UringTxType*     t = &TcpIp_UringTx[u->tx_head];
+
+    u->tx_pending = FALSE;
+
+    if (u->tx_cancel || (s->state == TCPIP_SOCKET_STATE_UNUSED)) {
+        u->tx_cancel = FALSE;
+        TcpIp_Uring_TxPop(index);
+        return;
+    }
+
+    if (res < 0) {
+        TcpIp_Uring_TxPop(index);
+        if (s->protocol == TCPIP_IPPROTO_TCP) {
+            /* stream is broken, remaining data can't be delivered */
+            TcpIp_SocketState_Enter(index, TCPIP_SOCKET_STATE_UNUSED);
+            return;
+        }
+    } else {
+        t->offset += (uint16)res;
+        if ((s->protocol != TCPIP_IPPROTO_TCP) || (t->offset >= t->len)) {
+            TcpIp_Uring_TxPop(index);
+        }
+    }
+
+    TcpIp_Uring_TxKick(index);
+
+    if (u->tx_shutdown && (u->tx_head == TCPIP_URING_TX_NONE)) {
+        u->tx_shutdown = FALSE;
+        TCPIP_SYSCALL_COUNT(close);
+        (void)shutdown(s->fd, SHUT_WR);
+    }
+}
+
+static void TcpIp_Uring_Reap(void)
+{
+    TcpIp_UringType* r = &TcpIp_Uring;
+    uint32           head;
+    uint32           tail;
+
+    head = *r->cq_head_ptr;
+    tail = __atomic_load_n(r->cq_tail_ptr, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        struct io_uring_cqe* cqe       = &r->cqes[head & *r->cq_mask_ptr];
+        uint64               user_data = cqe->user_data;
+        sint32               res       = cqe->res;
+
+        head++;
+        __atomic_store_n(r->cq_head_ptr, head, __ATOMIC_RELEASE);
+
+        switch ((uint32)(user_data >> 32)) {
+            case TCPIP_URING_OP_RX:
+                TcpIp_Uring_CompleteRx((TcpIp_SocketIdType)user_data, res);
+                break;
+            case TCPIP_URING_OP_TX:
+                TcpIp_Uring_CompleteTx((TcpIp_SocketIdType)user_data, res);
+                break;
+#if(TCPIP_WAKEUP_FD == STD_ON)
+            case TCPIP_URING_OP_WAKEUP:
+                TcpIp_Uring_ArmWakeup();
+                break;
+#endif
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON) && (TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+            case TCPIP_URING_OP_TIMER:
+                TcpIp_TimerProgrammedValid = FALSE;
+                TcpIp_Uring_ArmTimer();
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+}
+
+static void TcpIp_MainFunction_Process(int timeout)
+{
+    TcpIp_UringType* r = &TcpIp_Uring;
+
+    if (r->fd == -1) {
+        return;
+    }
+
+    r->processing = TRUE;
+    TcpIp_MainFunction_Handover();
+    if (timeout != 0) {
+        /* submit and sleep until the first completion */
+        TCPIP_WAIT_BEGIN(timeout);
+        (void)TcpIp_Uring_Enter(1u, IORING_ENTER_GETEVENTS, timeout);
+        TCPIP_WAIT_END();
+    } else if ((r->sq_pending > 0u) || (__atomic_load_n(r->sq_flags_ptr, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW)) {
+        /* one system call submits everything queued since last tick */
+        (void)TcpIp_Uring_Enter(0u, IORING_ENTER_GETEVENTS, 0);
+    }
+
+    TcpIp_Uring_Reap();
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    /* the eventfd read may have consumed a signal for work handed over since */
+    TcpIp_MainFunction_Handover();
+#endif
+
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TcpIp_Timer_Advance();
+#endif
+
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    /* there is no next tick to pick up requests re-armed while reaping */
+    if (r->sq_pending > 0u) {
+        (void)TcpIp_Uring_Enter(0u, 0u, 0);
+    }
+#endif
+    r->processing = FALSE;
+}
+#elif(TCPIP_CFG_ENABLE_EPOLL == STD_ON)
+static void TcpIp_MainFunction_Process(int timeout)
+{
+    TcpIp_SocketIdType index;
+    int                res;
+
+    TcpIp_MainFunction_Handover();
+
+    TCPIP_WAIT_BEGIN(timeout);
+    TCPIP_SYSCALL_COUNT(main_function);
+    res = epoll_wait(TcpIp_EpollFd, TcpIp_EpollEvents, TCPIP_CFG_EPOLL_EVENTS, timeout);
+    TCPIP_WAIT_END();
+    if (res > 0) {
+        /* something to do */
+        TcpIp_EpollCount = res;
+    } else {
+        /* error occured or nothing to do */
+        TcpIp_EpollCount = 0;
+    }
+
+    for (TcpIp_EpollNext = 0; TcpIp_EpollNext < TcpIp_EpollCount;) {
+        struct epoll_event* ev = &TcpIp_EpollEvents[TcpIp_EpollNext++];
+        if (ev->events == 0u) {
+            continue;
+        }
+#if(TCPIP_WAKEUP_FD == STD_ON)
+        if (ev->data.u64 == TCPIP_EPOLL_WAKEUP) {
+            TcpIp_Wakeup_Clear();
+            continue;
+        }
+#endif
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON) && (TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+        if (ev->data.u64 == TCPIP_EPOLL_TIMER) {
+            TcpIp_Timer_Clear();
+            continue;
+        }
+#endif
+        index = (TcpIp_SocketIdType)ev->data.u64;
+        TcpIp_PollFds[index].revents = (short)ev->events;
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+        TcpIp_Worker_Push(index);
+#else
+        TcpIp_SocketState_All(index);
+        TcpIp_PollFds[index].revents = 0;
+#endif
+    }
+    TcpIp_EpollCount = 0;
+    TcpIp_EpollNext  = 0;
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    TcpIp_Worker_Run();
+#endif
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+    /* the eventfd read may have consumed a signal for work handed over since */
+    TcpIp_MainFunction_Handover();
+#endif
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TcpIp_Timer_Advance();
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    TcpIp_TcpTx_UncorkAll();
+#endif
+}
+#else
+static void TcpIp_MainFunction_Process(int timeout)
 {
     TcpIp_SocketIdType index;
     int                res;
 
-    for (index = 0u; index < TCPIP_CFG_MAX_SOCKETS; ++index) {
+    TcpIp_MainFunction_Handover();
+
+    for (index = 0u; index < TcpIp_SocketCount; ++index) {
         TcpIp_PollFds[index].fd      = TcpIp_Sockets[index].fd;
         TcpIp_PollFds[index].revents = 0;
     }
 
-    res = poll(TcpIp_PollFds, TCPIP_CFG_MAX_SOCKETS, 0);
+    TCPIP_WAIT_BEGIN(timeout);
+    TCPIP_SYSCALL_COUNT(main_function);
+    res = poll(TcpIp_PollFds, TCPIP_POLLFDS_COUNT, timeout);
+    TCPIP_WAIT_END();
     if (res > 0) {
         /* something to do */
     } else if (res < 0) {
@@ -1010,8 +6250,112 @@ void TcpIp_MainFunction(void)
     } else {
         /* nothing to do */
     }
-    for (index = 0u; index < TCPIP_CFG_MAX_SOCKETS; ++index) {
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON)
+    if (TcpIp_PollFds[TCPIP_WAKEUP_INDEX].revents & POLLIN) {
+        TcpIp_Wakeup_Clear();
+    }
+    TcpIp_PollFds[TCPIP_WAKEUP_INDEX].revents = 0;
+#endif
+    for (index = 0u; index < TcpIp_SocketCount; ++index) {
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+        if (TcpIp_PollFds[index].revents != 0) {
+            TcpIp_Worker_Push(index);
+        }
+#else
         TcpIp_SocketState_All(index);
+#endif
+    }
+#if(TCPIP_CFG_ENABLE_WORKERS == STD_ON)
+    TcpIp_Worker_Run();
+#endif
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    TcpIp_Timer_Advance();
+#endif
+#if(TCPIP_CFG_ENABLE_TCP_COALESCE == STD_ON)
+    TcpIp_TcpTx_UncorkAll();
+#endif
+}
+#endif
+
+/**
+ * @brief Process all pending socket activity without blocking.
+ */
+void TcpIp_MainFunction(void)
+{
+    TcpIp_MainFunction_Process(0);
+}
+
+#if(TCPIP_CFG_ENABLE_READINESS_FD == STD_ON)
+/**
+ * @brief Get a file descriptor that polls readable whenever TcpIp_MainFunctionReady
+ *        has work to do.
+ * @return File descriptor or -1 if not initialized.
+ */
+int TcpIp_GetReadinessFd(void)
+{
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    return TcpIp_Uring.ready_fd;
+#else
+    return TcpIp_EpollFd;
+#endif
+}
+
+/**
+ * @brief Process socket activity after the readiness file descriptor fired.
+ */
+void TcpIp_MainFunctionReady(void)
+{
+#if(TCPIP_CFG_ENABLE_URING == STD_ON)
+    uint64 v;
+    /* consume the notification before reaping so later completions signal again */
+    TCPIP_SYSCALL_COUNT(main_function);
+    (void)read(TcpIp_Uring.ready_fd, &v, sizeof(v));
+#endif
+    TcpIp_MainFunction_Process(0);
+}
+#endif
+
+#if(TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT == STD_ON)
+/**
+ * @brief Block until there is socket activity, TcpIp_Wakeup is called or the
+ *        timeout expires, then process pending activity like TcpIp_MainFunction.
+ * @param[in] timeout Maximum time to block in milliseconds or TCPIP_TIMEOUT_INFINITE.
+ */
+void TcpIp_MainFunctionWait(uint32 timeout)
+{
+    int v;
+    if (timeout == TCPIP_TIMEOUT_INFINITE) {
+        v = -1;
+    } else if (timeout > (uint32)INT_MAX) {
+        v = INT_MAX;
+    } else {
+        v = (int)timeout;
     }
+
+#if(TCPIP_CFG_ENABLE_TIMERS == STD_ON)
+    {
+        /* don't sleep past the next timer */
+        int next = TcpIp_Timer_NextTimeout();
+        if ((next >= 0) && ((v < 0) || (next < v))) {
+            v = next;
+        }
+    }
+#endif
+
+    TcpIp_MainFunction_Process(v);
 }
 
+/**
+ * @brief Interrupt a TcpIp_MainFunctionWait blocked in another thread.
+ *
+ * Cheap when nobody is waiting, the eventfd is only signalled while a wait is in progress.
+ */
+void TcpIp_Wakeup(void)
+{
+    uint64 v = 1u;
+    if (__atomic_load_n(&TcpIp_Waiting, __ATOMIC_SEQ_CST)) {
+        TCPIP_SYSCALL_COUNT(wakeup);
+        (void)write(TcpIp_WakeupFd, &v, sizeof(v));
+    }
+}
+#endif
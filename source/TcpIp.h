@@ -258,6 +258,7 @@ typedef enum {
  */
 #define TCPIP_API_INIT                         0x01u
 #define TCPIP_API_GETVERSIONINFO               0x02u
+#define TCPIP_API_CLOSE                        0x04u
 #define TCPIP_API_BIND                         0x05u
 #define TCPIP_API_TCPCONNECT                   0x06u
 #define TCPIP_API_TCPLISTEN                    0x07u
@@ -278,9 +279,11 @@ typedef enum {
 #define TCPIP_API_GETREMOTEPHYSADDR            0x16u
 #define TCPIP_API_UDPTRANSMIT                  0x00u
 #define TCPIP_API_TCPTRANSMIT                  0x13u
-#define TCPIP_API_RXINDICATION                 0x04u
+#define TCPIP_API_RXINDICATION                 0x14u
 #define TCPIP_API_MAINFUNCTION                 0x15u
 #define TCPIP_API_GETSOCKET                    0x03u
+#define TCPIP_API_GETTXPOOLSTATS               0x80u
+#define TCPIP_API_RXRELEASE                    0x81u
 /**
  * @}
  */
@@ -290,7 +293,13 @@ typedef enum {
  * @req   SWS_TCPIP_00067
  */
 typedef struct {
-    uint8 dummy;
+    uint16 max_sockets;     /**< Number of sockets, 0 selects TCPIP_CFG_MAX_SOCKETS */
+    uint16 max_packetsize;  /**< Size of socket buffers, 0 or at most TCPIP_CFG_MAX_PACKETSIZE */
+    uint8  max_controller;  /**< Number of controllers, 0 selects TCPIP_CFG_MAX_CONTROLLER */
+    uint16 tx_buffers;      /**< Buffers per transmit pool class, 0 selects TCPIP_CFG_TX_POOL_BUFFERS */
+    uint16 rx_buffers;      /**< Receive buffers to lend, 0 selects TCPIP_CFG_RX_LOAN_BUFFERS */
+    void*  arena;           /**< Memory all tables are placed in, NULL selects built in storage */
+    uint32 arena_size;      /**< Size of arena in bytes, see TcpIp_GetArenaSize */
 } TcpIp_ConfigType;
 
 /**
@@ -339,6 +348,96 @@ typedef union {
     TcpIp_SockAddrInet6Type inet6;
 } TcpIp_SockAddrStorageType;
 
+/**
+ * @brief Counters of the transmit queue (TCPIP_CFG_ENABLE_TX_QUEUE)
+ */
+typedef struct {
+    uint32 depth;         /**< entries currently queued */
+    uint32 depth_max;     /**< highest number of entries queued at once */
+    uint32 enqueued;      /**< entries accepted */
+    uint32 rejected;      /**< entries refused as the queue was full */
+    uint32 failed;        /**< entries the socket refused to transmit */
+    uint64 latency_max;   /**< longest time in [us] from enqueue until transmit */
+    uint64 latency_total; /**< sum of all times in [us] from enqueue until transmit */
+} TcpIp_TxQueueStatsType;
+
+/**
+ * @brief One datagram of a batched receive indication (TCPIP_CFG_ENABLE_RX_BATCH_INDICATION)
+ */
+typedef struct {
+    const TcpIp_SockAddrType* remote; /**< address the datagram was received from */
+    uint8*                    buf;    /**< datagram payload, only valid during the indication */
+    uint16                    len;    /**< payload length in bytes */
+} TcpIp_RxBatchEntryType;
+
+/**
+ * @brief One datagram of a batched transmit (TCPIP_CFG_ENABLE_SENDMMSG)
+ */
+typedef struct {
+    const uint8*              data;   /**< datagram payload */
+    const TcpIp_SockAddrType* remote; /**< address to send the datagram to */
+    uint16                    len;    /**< payload length in bytes */
+    Std_ReturnType            result; /**< set to the outcome of this datagram */
+} TcpIp_UdpTxEntryType;
+
+/**
+ * @brief One buffer of a vectored TCP transmit (TCPIP_CFG_ENABLE_TCP_TX_VECTOR)
+ */
+typedef struct {
+    const uint8*              data;   /**< start of the buffer */
+    uint32                    len;    /**< length in bytes */
+} TcpIp_TxSegmentType;
+
+/**
+ * @brief Usage of the receive buffer pool (TCPIP_CFG_ENABLE_RX_LOAN)
+ */
+typedef struct {
+    uint16 buffers;       /**< number of buffers in the pool */
+    uint32 in_use;        /**< buffers currently lent out or being received into */
+    uint32 in_use_max;    /**< highest number of buffers in use at once */
+    uint32 loaned;        /**< buffers kept by upper layer */
+    uint32 fallback;      /**< packets copied from the stack as the pool was empty */
+} TcpIp_RxPoolStatsType;
+
+/**
+ * @brief Usage of one size class of the shared transmit buffer pool
+ */
+typedef struct {
+    uint16 size;          /**< size of each buffer in bytes */
+    uint16 buffers;       /**< number of buffers in the class */
+    uint16 in_use;        /**< buffers currently borrowed */
+    uint16 in_use_max;    /**< highest number of buffers borrowed at once */
+    uint32 exhausted;     /**< requests this class could not serve as all buffers were borrowed */
+} TcpIp_TxPoolStatsType;
+
+/**
+ * @brief System calls issued on behalf of each API (TCPIP_CFG_ENABLE_SYSCALL_STATS)
+ */
+typedef struct {
+    uint32 get_socket;       /**< TcpIp_SoAdGetSocket */
+    uint32 bind;             /**< TcpIp_Bind */
+    uint32 tcp_connect;      /**< TcpIp_TcpConnect */
+    uint32 tcp_listen;       /**< TcpIp_TcpListen */
+    uint32 tcp_transmit;     /**< TcpIp_TcpTransmit, including sends of data it left buffered */
+    uint32 udp_transmit;     /**< TcpIp_UdpTransmit */
+    uint32 change_parameter; /**< TcpIp_ChangeParameter */
+    uint32 close;            /**< shutdown and release of sockets, whoever requested it */
+    uint32 wakeup;           /**< TcpIp_Wakeup, also when called by TcpIp_TcpReceived */
+    uint32 events;           /**< changes to the epoll interest set, whoever requested it */
+    uint32 main_function;    /**< polling, accept, receive and timers of TcpIp_MainFunction */
+} TcpIp_SyscallStatsType;
+
+/**
+ * @brief Connections taken from listening sockets (TCPIP_CFG_ENABLE_ACCEPT_STATS)
+ */
+typedef struct {
+    uint32 accepted;         /**< connections taken from a backlog */
+    uint32 dropped;          /**< connections closed right away as no socket slot was free */
+    uint32 budget_exhausted; /**< readiness events that used up TCPIP_CFG_ACCEPT_BUDGET, unless edge triggered the rest waited for the next main function */
+    uint32 backlog_full;     /**< of those, events that found a backlog at its limit, handshakes may have been dropped */
+    uint32 backlog_max;      /**< longest backlog seen by those events, compare with the channels given to TcpIp_TcpListen */
+} TcpIp_AcceptStatsType;
+
 /**
  * @brief socket identifier type for unique identification of a TcpIp stack socket.
  *        TCPIP_SOCKETID_INVALID shall specify an invalid socket handle.
@@ -372,6 +471,14 @@ void TcpIp_Init(
         const TcpIp_ConfigType*     config
     );
 
+/**
+ * @brief Get the size of arena TcpIp_Init needs for a configuration
+ * @return Size in bytes, 0 if the configuration is not supported
+ */
+uint32 TcpIp_GetArenaSize(
+        const TcpIp_ConfigType*     config
+    );
+
 
 Std_ReturnType TcpIp_Bind(
         TcpIp_SocketIdType          id,
@@ -396,6 +503,29 @@ Std_ReturnType TcpIp_UdpTransmit(
         uint16                      len
     );
 
+Std_ReturnType TcpIp_UdpTransmitBatch(
+        TcpIp_SocketIdType          id,
+        TcpIp_UdpTxEntryType*       entries,
+        uint16                      count
+    );
+
+Std_ReturnType TcpIp_UdpTransmitFanout(
+        TcpIp_SocketIdType          id,
+        const uint8*                data,
+        uint16                      len,
+        const TcpIp_SockAddrType**  remotes,
+        Std_ReturnType*             results,
+        uint16                      count
+    );
+
+Std_ReturnType TcpIp_UdpTransmitSegmented(
+        TcpIp_SocketIdType          id,
+        const uint8*                data,
+        const TcpIp_SockAddrType*   remote,
+        uint32                      len,
+        uint16                      segment
+    );
+
 Std_ReturnType TcpIp_TcpTransmit(
         TcpIp_SocketIdType  id,
         const uint8*        data,
@@ -403,6 +533,53 @@ Std_ReturnType TcpIp_TcpTransmit(
         boolean             force
     );
 
+Std_ReturnType TcpIp_TcpTransmitVector(
+        TcpIp_SocketIdType          id,
+        const TcpIp_TxSegmentType*  segments,
+        uint16                      count
+    );
+
+Std_ReturnType TcpIp_UdpTransmitQueued(
+        TcpIp_SocketIdType          id,
+        const uint8*                data,
+        const TcpIp_SockAddrType*   remote,
+        uint16                      len
+    );
+
+Std_ReturnType TcpIp_TcpTransmitQueued(
+        TcpIp_SocketIdType          id,
+        const uint8*                data,
+        uint16                      len
+    );
+
+void TcpIp_GetTxQueueStats(
+        TcpIp_TxQueueStatsType*     stats
+    );
+
+/**
+ * @brief Return a buffer kept from SoAd_RxIndicationLoan (TCPIP_CFG_ENABLE_RX_LOAN), callable from any thread
+ */
+Std_ReturnType TcpIp_RxRelease(
+        uint8*                      buf
+    );
+
+void TcpIp_GetRxPoolStats(
+        TcpIp_RxPoolStatsType*      stats
+    );
+
+Std_ReturnType TcpIp_GetTxPoolStats(
+        uint8                       cls,
+        TcpIp_TxPoolStatsType*      stats
+    );
+
+void TcpIp_GetSyscallStats(
+        TcpIp_SyscallStatsType*     stats
+    );
+
+void TcpIp_GetAcceptStats(
+        TcpIp_AcceptStatsType*      stats
+    );
+
 Std_ReturnType TcpIp_TcpReceived(
         TcpIp_SocketIdType id,
         uint32             len
@@ -424,6 +601,33 @@ Std_ReturnType TcpIp_RequestComMode(
         TcpIp_StateType state
     );
 
-void TcpIp_MainFunction();
+void TcpIp_MainFunction(void);
+
+/**
+ * @brief Get the file descriptor covering all sockets (TCPIP_CFG_ENABLE_READINESS_FD)
+ * @return File descriptor to poll for readability, -1 if not available
+ */
+int TcpIp_GetReadinessFd(void);
+
+/**
+ * @brief Process socket activity once the readiness file descriptor is readable
+ */
+void TcpIp_MainFunctionReady(void);
+
+/**
+ * @brief Timeout value for TcpIp_MainFunctionWait to block until activity.
+ */
+#define TCPIP_TIMEOUT_INFINITE 0xFFFFFFFFu
+
+/**
+ * @brief Block for socket activity then process it (TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT)
+ * @param[in] timeout Maximum time to block in milliseconds or TCPIP_TIMEOUT_INFINITE.
+ */
+void TcpIp_MainFunctionWait(uint32 timeout);
+
+/**
+ * @brief Interrupt a TcpIp_MainFunctionWait, safe to call from any thread
+ */
+void TcpIp_Wakeup(void);
 
 #endif /* TCPIP_H_ */
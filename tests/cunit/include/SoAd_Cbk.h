@@ -29,6 +29,19 @@ void SoAd_RxIndication(
         uint16                      Length
     );
 
+void SoAd_RxIndicationBatch(
+        TcpIp_SocketIdType              SocketId,
+        const TcpIp_RxBatchEntryType*   Entries,
+        uint16                          Count
+    );
+
+Std_ReturnType SoAd_RxIndicationLoan(
+        TcpIp_SocketIdType          SocketId,
+        const TcpIp_SockAddrType*   RemoteAddrPtr,
+        uint8*                      BufPtr,
+        uint16                      Length
+    );
+
 void SoAd_TcpIpEvent(
         TcpIp_SocketIdType          SocketId,
         TcpIp_EventType             Event
@@ -55,4 +68,11 @@ BufReq_ReturnType SoAd_CopyTxData(
         uint16 BufLength
     );
 
+BufReq_ReturnType SoAd_GetTxSegments(
+        TcpIp_SocketIdType      SocketId,
+        TcpIp_TxSegmentType*    Segments,
+        uint16*                 Count,
+        uint32                  Length
+    );
+
 #endif /* SOAD_CBK_H_ */
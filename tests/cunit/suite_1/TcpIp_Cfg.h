@@ -22,5 +22,11 @@
 
 #define TCPIP_CFG_MAX_SOCKETS  10u
 #define TCPIP_CFG_ENABLE_DEVELOPMENT_ERROR STD_ON
+#define TCPIP_CFG_ENABLE_SYSCALL_STATS STD_ON
+#define TCPIP_CFG_ENABLE_SENDMMSG STD_ON
+#define TCPIP_CFG_ENABLE_UDP_GSO STD_ON
+#define TCPIP_CFG_ENABLE_TCP_TX_VECTOR STD_ON
+#define TCPIP_CFG_ENABLE_ACCEPT_STATS STD_ON
+#define TCPIP_CFG_ACCEPT_BUDGET 4u
 
 #endif /* TCPIP_CFG_H_ */
@@ -0,0 +1,40 @@
+/* Copyright (C) 2015 Joakim Plate
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TCPIP_CFG_H_
+#define TCPIP_CFG_H_
+
+#include "Std_Types.h"
+
+#define TCPIP_CFG_MAX_SOCKETS  10u
+#define TCPIP_CFG_ENABLE_DEVELOPMENT_ERROR STD_ON
+#define TCPIP_CFG_ENABLE_EPOLL STD_ON
+#define TCPIP_CFG_ENABLE_EPOLL_EDGE STD_ON
+#define TCPIP_CFG_ENABLE_MAINFUNCTION_WAIT STD_ON
+#define TCPIP_CFG_ENABLE_WORKERS STD_ON
+#define TCPIP_CFG_ENABLE_SOCKET_GENERATION STD_ON
+#define TCPIP_CFG_ENABLE_RECVMMSG STD_ON
+#define TCPIP_CFG_ENABLE_RX_BATCH_INDICATION STD_ON
+#define TCPIP_CFG_ENABLE_RX_CREDIT STD_ON
+#define TCPIP_CFG_RX_CREDIT 256u
+#define TCPIP_CFG_RX_RING_SIZE 1024u
+#define TCPIP_CFG_ENABLE_TCP_TX_BUFFER STD_ON
+#define TCPIP_CFG_ENABLE_SENDMMSG STD_ON
+#define TCPIP_CFG_ENABLE_LISTEN_SHARDS STD_ON
+#define TCPIP_CFG_ENABLE_SHARD_AFFINITY STD_ON
+
+#endif /* TCPIP_CFG_H_ */
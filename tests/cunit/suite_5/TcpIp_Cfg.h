@@ -0,0 +1,38 @@
+/* Copyright (C) 2015 Joakim Plate
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TCPIP_CFG_H_
+#define TCPIP_CFG_H_
+
+#include "Std_Types.h"
+
+#define TCPIP_CFG_MAX_SOCKETS  10u
+#define TCPIP_CFG_ENABLE_DEVELOPMENT_ERROR STD_ON
+#define TCPIP_CFG_ENABLE_WORKERS STD_ON
+#define TCPIP_CFG_ENABLE_TX_QUEUE STD_ON
+#define TCPIP_CFG_ENABLE_TIMERS STD_ON
+#define TCPIP_CFG_SHUTDOWN_TIMEOUT 200u
+#define TCPIP_CFG_IDLE_TIMEOUT 500u
+#define TCPIP_CFG_ENABLE_SOCKET_GENERATION STD_ON
+#define TCPIP_CFG_ENABLE_RX_LOAN STD_ON
+#define TCPIP_CFG_ENABLE_RX_CREDIT STD_ON
+#define TCPIP_CFG_RX_CREDIT 256u
+#define TCPIP_CFG_ENABLE_ZEROCOPY STD_ON
+#define TCPIP_CFG_ENABLE_TCP_COALESCE STD_ON
+#define TCPIP_CFG_ENABLE_SYSCALL_STATS STD_ON
+
+#endif /* TCPIP_CFG_H_ */